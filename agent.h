@@ -26,15 +26,16 @@ public:
 
   list<Agent*> getAgents();
   // returns a list of linked agents
+
   
-  void compare(Agent* peer, double assimilation_treshold, double assimilation_step);
-  // adjusts attribute based on the outcome of a social comparison
-  
+  static void resetIds() { id_counter = 0; }
+  // lets the next agent start counting from 0 again
+
   friend class Link;
   // the Link class manages the (private) list of links
 
 private:
-  static int id_counter;
+  static __thread int id_counter; // one per thread, so that replicas can run side by side
   int id;
   double attribute;
   list<Link*> links; // list of pointers to Link objects
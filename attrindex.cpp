@@ -0,0 +1,113 @@
+/*
+attrindex.cpp: the implementation of the AttributeIndex class
+*/
+
+#include "main.h"
+#include "agent.h"
+#include "attrindex.h"
+
+#include <algorithm>
+
+#define MAXIMUM_ATTEMPTS 32
+
+AttributeIndex::AttributeIndex(int nr_of_agents, Agent population[], double treshold)
+// constructor; attributes lie between 0 and 1, so there are 1/treshold
+// buckets, or wider ones if that would be more buckets than agents
+: treshold(treshold),
+  width(max(treshold, 1.0 / nrOfBuckets(nr_of_agents, treshold))),
+  population(population),
+  buckets(nrOfBuckets(nr_of_agents, treshold)),
+  bucket(nr_of_agents),
+  position(nr_of_agents)
+{
+  for (int i=0; i<nr_of_agents; i++)
+  {
+    bucket[i] = bucketOf(population[i].getattr());
+    position[i] = buckets[bucket[i]].size();
+    buckets[bucket[i]].push_back(&population[i]);
+  }
+}
+
+
+
+int AttributeIndex::nrOfBuckets(int nr_of_agents, double treshold)
+// returns the nr. of buckets that an index for this treshold uses
+{
+  // (in doubles, since 1/treshold may not fit in an int)
+  double nr = floor(1 / treshold) + 1;
+  if (nr > nr_of_agents) nr = nr_of_agents;
+  if (nr < 1) nr = 1;
+  return static_cast<int>(nr);
+}
+
+
+
+int AttributeIndex::bucketOf(double attribute)
+// returns the number of the bucket that holds the given attribute value
+{
+  int nr = static_cast<int>(attribute / width);
+  if (nr < 0) return 0;
+  if (nr >= static_cast<int>(buckets.size())) return buckets.size() - 1;
+  return nr;
+}
+
+
+
+void AttributeIndex::update(Agent* agent)
+// moves an agent to its new bucket in constant time
+{
+  int i = indexOf(agent);
+  int old_bucket = bucket[i];
+  int new_bucket = bucketOf(agent->getattr());
+
+  // nothing to do if the agent stays within the same bucket
+  if (old_bucket == new_bucket) return;
+
+  // fill the gap in the old bucket with its last agent...
+  vector<Agent*> &old_agents = buckets[old_bucket];
+  Agent* last = old_agents.back();
+  old_agents[position[i]] = last;
+  position[indexOf(last)] = position[i];
+  old_agents.pop_back();
+
+  // ... and append the agent to the new bucket
+  bucket[i] = new_bucket;
+  position[i] = buckets[new_bucket].size();
+  buckets[new_bucket].push_back(agent);
+}
+
+
+
+Agent* AttributeIndex::getSimilar(Agent* agent)
+// returns a random agent whose attribute lies within the treshold
+{
+  // since the buckets are at least as wide as the treshold, all candidates
+  // are in the agent's own bucket or in one of its two neighbours:
+  int nr = bucket[indexOf(agent)];
+  int first = (nr > 0) ? nr - 1 : nr;
+  int last = (nr < static_cast<int>(buckets.size()) - 1) ? nr + 1 : nr;
+
+  int nr_of_candidates = 0;
+  for (int b=first; b<=last; b++) nr_of_candidates += buckets[b].size();
+
+  // pick a random candidate and reject it if it is too different;
+  // this keeps the choice uniform among all the agents within the width
+  for (int attempt=0; attempt<MAXIMUM_ATTEMPTS; attempt++)
+  {
+    int random_candidate = gsl_rng_uniform_int(r, nr_of_candidates);
+    int b = first;
+    while (random_candidate >= static_cast<int>(buckets[b].size()))
+    {
+      random_candidate -= buckets[b].size();
+      b++;
+    }
+    Agent* candidate = buckets[b][random_candidate];
+
+    if (candidate != agent && abs(candidate->getattr() - agent->getattr()) <= treshold)
+    {
+      return candidate;
+    }
+  }
+  if (DEBUG) cerr << "No similar agent found for agent " << agent->getid() << endl;
+  return agent;
+}
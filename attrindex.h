@@ -0,0 +1,40 @@
+/*
+attrindex.h: interface of the AttributeIndex class
+*/
+
+#ifndef ATTRINDEX_H
+#define ATTRINDEX_H
+
+#include "main.h"
+
+class AttributeIndex
+{
+public:
+
+  // constructor; sorts all agents into buckets at least as wide as the link treshold
+  AttributeIndex(int nr_of_agents, Agent population[], double treshold);
+
+  void update(Agent* agent);
+  // moves an agent to its new bucket after its attribute has changed
+
+  Agent* getSimilar(Agent* agent);
+  // returns a random agent whose attribute lies within the treshold of the
+  // given agent's attribute, or the agent itself if none could be found
+
+  static int nrOfBuckets(int nr_of_agents, double treshold);
+  // returns the nr. of buckets that an index for this treshold uses
+
+private:
+  int bucketOf(double attribute);
+  int indexOf(Agent* agent) { return agent - population; }
+
+  double treshold;
+  double width; // the width of a bucket; never less than the treshold
+  Agent* population;
+  vector< vector<Agent*> > buckets; // agents sorted by attribute range
+  vector<int> bucket; // bucket number of each agent
+  vector<int> position; // position of each agent within its bucket
+};
+
+#endif
+// ATTRINDEX_H
@@ -0,0 +1,195 @@
+/*
+batch.cpp: runs a batch of simulations in forked worker processes
+*/
+
+#include "main.h"
+#include "batch.h"
+
+#include <cstdio>
+#include <sys/mman.h>
+#include <sys/wait.h>
+
+enum SlotState
+{
+  SLOT_PENDING = 0, // waiting for a worker, or being run by one
+  SLOT_DONE = 1,
+  SLOT_FAILED = 2
+};
+
+struct BatchSlot
+// one point of the batch; lives in memory that is shared with the workers
+{
+  Parameters parameters;
+  unsigned long seed;
+  bool with_avgpath;
+  int state; // one of the SlotStates
+  int attempts; // the nr. of times the point was started
+  pid_t worker; // the process that claimed the point, or 0 if there is none
+  Stats stats;
+};
+
+
+
+static void work(BatchSlot* slots, int nr_of_slots)
+// the main loop of a worker process: claims and runs pending points
+{
+  pid_t pid = getpid();
+  for (int i=0; i<nr_of_slots; i++)
+  {
+    if (slots[i].state != SLOT_PENDING) continue;
+    if (!__sync_bool_compare_and_swap(&slots[i].worker, 0, pid)) continue;
+    slots[i].attempts++;
+
+    Stats stats = simulate(slots[i].parameters, slots[i].seed, slots[i].with_avgpath);
+    slots[i].stats = stats;
+    __sync_synchronize(); // the stats must be in place before the point is done
+    slots[i].state = SLOT_DONE;
+
+    // a failed point may have been put back before the current one
+    i = -1;
+  }
+}
+
+
+
+static pid_t startWorker(BatchSlot* slots, int nr_of_slots)
+// forks a new worker process; returns its pid, or -1 if that failed
+{
+  // don't let the worker inherit unwritten output of the parent
+  fflush(NULL);
+
+  pid_t pid = fork();
+  if (pid == 0)
+  {
+    work(slots, nr_of_slots);
+    _exit(0);
+  }
+  if (pid < 0) cerr << "error: Could not start a worker process\n";
+  return pid;
+}
+
+
+
+void runBatch(vector<Parameters> &points, vector<unsigned long> &seeds, int nr_of_workers,
+              bool with_avgpath, vector<Stats> &results, vector<bool> &failed)
+// runs a simulation for each of the points in at most nr_of_workers processes
+{
+  int nr_of_slots = points.size();
+  results.resize(nr_of_slots);
+  failed.assign(nr_of_slots, false);
+  if (!nr_of_slots) return;
+
+  // the table of points is shared with all (future) workers
+  size_t size = nr_of_slots * sizeof(BatchSlot);
+  void* memory = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+  if (memory == MAP_FAILED)
+  {
+    cerr << "fatal error: Could not allocate shared memory for the batch\n";
+    exit(1);
+  }
+  BatchSlot* slots = static_cast<BatchSlot*>(memory);
+  for (int i=0; i<nr_of_slots; i++)
+  {
+    slots[i].parameters = points[i];
+    slots[i].seed = seeds[i];
+    slots[i].with_avgpath = with_avgpath;
+    slots[i].state = SLOT_PENDING;
+    slots[i].attempts = 0;
+    slots[i].worker = 0;
+  }
+
+  if (nr_of_workers > nr_of_slots) nr_of_workers = nr_of_slots;
+  int nr_running = 0;
+  for (int w=0; w<nr_of_workers; w++)
+  {
+    if (startWorker(slots, nr_of_slots) > 0) nr_running++;
+  }
+
+  while (nr_running > 0)
+  {
+    int status;
+    pid_t pid = waitpid(-1, &status, 0);
+    if (pid < 0) break;
+    nr_running--;
+    if (WIFEXITED(status) && WEXITSTATUS(status) == 0) continue;
+
+    // the worker died; retry its point or give up on it
+    for (int i=0; i<nr_of_slots; i++)
+    {
+      if (slots[i].state != SLOT_PENDING || slots[i].worker != pid) continue;
+
+      cerr << "error: Worker " << pid << " ";
+      if (WIFSIGNALED(status)) cerr << "was killed by signal " << WTERMSIG(status);
+      else cerr << "exited with status " << WEXITSTATUS(status);
+      cerr << " while running point " << i << " (attempt " << slots[i].attempts << ")\n";
+
+      if (slots[i].attempts < BATCH_ATTEMPTS)
+      { // try again, but not with the same random numbers
+        slots[i].seed += nr_of_slots;
+        __sync_synchronize();
+        slots[i].worker = 0;
+      }
+      else slots[i].state = SLOT_FAILED;
+    }
+
+    // replace the worker if there is still work to do
+    bool pending = false;
+    for (int i=0; i<nr_of_slots && !pending; i++) pending = (slots[i].state == SLOT_PENDING && slots[i].worker == 0);
+    if (pending && startWorker(slots, nr_of_slots) > 0) nr_running++;
+  }
+
+  for (int i=0; i<nr_of_slots; i++)
+  {
+    results[i] = slots[i].stats;
+    failed[i] = (slots[i].state != SLOT_DONE);
+  }
+  munmap(memory, size);
+}
+
+
+
+void runGrid(const Parameters &parameters, int nr_of_workers, unsigned long seed, bool verbose)
+// runs the same grid as run.sh and prints the final statistics of every point
+{
+  vector<Parameters> points;
+  vector<unsigned long> seeds;
+  vector<Stats> results;
+  vector<bool> failed;
+
+  for (int x=1; x<=9; x++)
+    for (int y=1; y<=9; y++)
+      for (int z=1; z<=9; z++)
+      {
+        Parameters point = parameters;
+        point.assimilation_treshold = x * 0.05;
+        point.assimilation_step = y * 0.05;
+        point.link_treshold = z * 0.05;
+        points.push_back(point);
+        seeds.push_back(seed + points.size());
+      }
+
+  if (verbose) cerr << "Running " << points.size() << " simulations in " << nr_of_workers << " processes...\n";
+  runBatch(points, seeds, nr_of_workers, true, results, failed);
+
+  cout << "pop_size nr_links ass_tres ass_step lnk_tres itrtions rel_size density  clustrng assrtvty avgpath\n";
+  for (unsigned int i=0; i<points.size(); i++)
+  {
+    printf ("%-9d", points[i].population_size);
+    printf ("%-9d", points[i].nr_of_links);
+    printf ("%-9.2f", points[i].assimilation_treshold);
+    printf ("%-9.2f", points[i].assimilation_step);
+    printf ("%-9.2f", points[i].link_treshold);
+    if (failed[i])
+    {
+      printf ("failed\n");
+      continue;
+    }
+    printf ("%-9d", results[i].iterations);
+    printf ("%-9d", results[i].links);
+    printf ("%-9.2f", results[i].density);
+    printf ("%-9.2f", results[i].clustering);
+    printf ("%-9.2f", results[i].assortativity);
+    printf ("%-9.2f", results[i].avgpath);
+    cout << endl;
+  }
+}
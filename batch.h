@@ -0,0 +1,27 @@
+/*
+batch.h: runs a batch of simulations in forked worker processes
+
+The points of the batch are kept in a table in shared memory. Every worker
+takes the next pending point from the table, runs it, and writes its final
+statistics back into the table. A worker that crashes (or exits because of
+a fatal error) only takes its current point down with it: the point is
+retried by a new worker, and recorded as failed after BATCH_ATTEMPTS tries.
+*/
+
+#ifndef BATCH_H
+#define BATCH_H
+
+#include "main.h"
+#include "simulation.h"
+
+#define BATCH_ATTEMPTS 3 // nr. of times a point is tried before it counts as failed
+
+void runBatch(vector<Parameters> &points, vector<unsigned long> &seeds, int nr_of_workers,
+              bool with_avgpath, vector<Stats> &results, vector<bool> &failed);
+// runs a simulation for each of the points in at most nr_of_workers processes
+
+void runGrid(const Parameters &parameters, int nr_of_workers, unsigned long seed, bool verbose);
+// runs the same grid as run.sh and prints the final statistics of every point to STDOUT
+
+#endif
+// BATCH_H
@@ -0,0 +1,183 @@
+/*
+ensemble.cpp: runs replicas of one simulation side by side
+*/
+
+#include "main.h"
+#include "ensemble.h"
+
+#include <pthread.h>
+#include <gsl/gsl_cdf.h>
+
+#define NR_OF_STATS 7 // removed links, links, density, clustering, assortativity, avgpath, iterations
+
+struct Replica
+{
+  const Parameters* parameters;
+  unsigned long seed;
+  pthread_barrier_t* barrier; // shared by all replicas and the main thread
+  vector<Stats> stats; // the statistics after each iteration
+};
+
+struct Summary
+{
+  double mean;
+  double sd;
+  double low; // the lower bound of the 95% confidence interval
+  double high; // the upper bound of the 95% confidence interval
+};
+
+
+
+static void* runReplica(void* arg)
+// runs one replica, and waits for the others after every iteration
+{
+  Replica* replica = static_cast<Replica*>(arg);
+
+  // every replica has its own random number generator
+  r = gsl_rng_alloc(gsl_rng_mt19937);
+  gsl_rng_set(r, replica->seed);
+
+  Simulation simulation(*replica->parameters);
+  for (int row=0; row<=MAXIMUM_ITERATIONS+1; row++)
+  {
+    // the last row gets the complete (and slow) statistics
+    replica->stats[row] = simulation.getStats(row > MAXIMUM_ITERATIONS);
+    pthread_barrier_wait(replica->barrier);
+
+    // a stable replica stops counting iterations, like a single run
+    // stops early, but still takes part in every row
+    if (row <= MAXIMUM_ITERATIONS && !simulation.isQuiescent()) simulation.iterate();
+  }
+
+  gsl_rng_free(r);
+  return NULL;
+}
+
+
+
+static Summary summarize(const vector<double> &values)
+// returns the mean, standard deviation and 95% confidence interval (Student's t)
+{
+  Summary summary;
+  int n = values.size();
+  double sum = 0;
+  double sum_2 = 0;
+  for (int i=0; i<n; i++)
+  {
+    sum += values[i];
+    sum_2 += values[i] * values[i];
+  }
+  summary.mean = sum / n;
+  double variance = (n > 1) ? (sum_2 - sum * sum / n) / (n - 1) : 0;
+  summary.sd = (variance > 0) ? sqrt(variance) : 0;
+
+  double margin = (n > 1) ? gsl_cdf_tdist_Pinv(0.975, n - 1) * summary.sd / sqrt(static_cast<double>(n)) : 0;
+  summary.low = summary.mean - margin;
+  summary.high = summary.mean + margin;
+  return summary;
+}
+
+
+
+static double measure(const Summary &summary, int m)
+// returns one of the four measures of a summary
+{
+  switch (m)
+  {
+    case 0: return summary.mean;
+    case 1: return summary.sd;
+    case 2: return summary.low;
+    default: return summary.high;
+  }
+}
+
+
+
+static void summarizeRow(vector<Replica> &replicas, int row, Summary summaries[])
+// summarizes all statistics of one row over the replicas
+{
+  vector<double> values[NR_OF_STATS];
+  for (unsigned int i=0; i<replicas.size(); i++)
+  {
+    Stats &stats = replicas[i].stats[row];
+    values[0].push_back(stats.removed);
+    values[1].push_back(stats.links);
+    values[2].push_back(stats.density);
+    values[3].push_back(stats.clustering);
+    values[4].push_back(stats.assortativity);
+    values[5].push_back(stats.avgpath);
+    values[6].push_back(stats.iterations);
+  }
+  for (int s=0; s<NR_OF_STATS; s++) summaries[s] = summarize(values[s]);
+}
+
+
+
+void runEnsemble(const Parameters &parameters, int nr_of_replicas, unsigned long seed, bool verbose)
+// runs the replicas and prints the spread of their statistics
+{
+  const char* measures[] = { "mean", "sd", "ci_low", "ci_high" };
+  Summary summaries[NR_OF_STATS];
+
+  pthread_barrier_t barrier;
+  pthread_barrier_init(&barrier, NULL, nr_of_replicas + 1);
+
+  if (verbose) cerr << "Starting " << nr_of_replicas << " replicas...\n";
+
+  vector<Replica> replicas(nr_of_replicas);
+  vector<pthread_t> threads(nr_of_replicas);
+  for (int i=0; i<nr_of_replicas; i++)
+  {
+    replicas[i].parameters = &parameters;
+    replicas[i].seed = seed + i;
+    replicas[i].barrier = &barrier;
+    replicas[i].stats.resize(MAXIMUM_ITERATIONS + 2);
+    if (pthread_create(&threads[i], NULL, runReplica, &replicas[i]) != 0)
+    {
+      cerr << "fatal error: Could not start the thread of replica " << i << endl;
+      exit(1);
+    }
+  }
+
+  // print the spread of the stats after every iteration:
+  cerr << "#Iteration Measure Removed Links         Density    Cluster.   Assort.\n";
+  for (int row=0; row<=MAXIMUM_ITERATIONS; row++)
+  {
+    pthread_barrier_wait(&barrier);
+    summarizeRow(replicas, row, summaries);
+    for (int m=0; m<4; m++)
+    {
+      fprintf (stderr, "%-11d", row);
+      fprintf (stderr, "%-8s", measures[m]);
+      fprintf (stderr, "%-22.1f", measure(summaries[0], m));
+      fprintf (stderr, "%-11.2f", measure(summaries[2], m));
+      fprintf (stderr, "%-11.2f", measure(summaries[3], m));
+      fprintf (stderr, "%-11.2f", measure(summaries[4], m));
+      cerr << endl;
+    }
+  }
+
+  // wait for the final stats
+  pthread_barrier_wait(&barrier);
+  for (int i=0; i<nr_of_replicas; i++) pthread_join(threads[i], NULL);
+  pthread_barrier_destroy(&barrier);
+
+  if (verbose) cerr << "Sending results to STDOUT...\n";
+
+  summarizeRow(replicas, MAXIMUM_ITERATIONS + 1, summaries);
+  cout << "pop_size nr_links ass_tres ass_step lnk_tres itrtions replicas measure  rel_size density  clustrng assrtvty avgpath\n";
+  for (int m=0; m<4; m++)
+  {
+    printf ("%-9d", parameters.population_size);
+    printf ("%-9d", parameters.nr_of_links);
+    printf ("%-9.2f", parameters.assimilation_treshold);
+    printf ("%-9.2f", parameters.assimilation_step);
+    printf ("%-9.2f", parameters.link_treshold);
+    printf ("%-9.1f", measure(summaries[6], m));
+    printf ("%-9d", nr_of_replicas);
+    printf ("%-9s", measures[m]);
+    printf ("%-9.1f", measure(summaries[1], m));
+    for (int s=2; s<6; s++) printf ("%-9.4f", measure(summaries[s], m));
+    cout << endl;
+  }
+}
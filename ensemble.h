@@ -0,0 +1,21 @@
+/*
+ensemble.h: runs replicas of one simulation side by side
+
+Every replica runs in its own thread, with its own random number generator
+and seed. The replicas move in lockstep: after each iteration they wait for
+each other, so that the spread of the statistics over the replicas can be
+printed while the simulation is still running.
+*/
+
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include "main.h"
+#include "simulation.h"
+
+void runEnsemble(const Parameters &parameters, int nr_of_replicas, unsigned long seed, bool verbose);
+// runs the replicas and prints the mean, standard deviation and 95% confidence
+// interval of the statistics after every iteration (STDERR) and at the end (STDOUT)
+
+#endif
+// ENSEMBLE_H
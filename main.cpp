@@ -9,23 +9,35 @@ by J.J.Vens, 2011
 #include "main.h"
 #include "agent.h"
 #include "link.h"
-
-#define MAXIMUM_ITERATIONS 25
+#include "attrindex.h"
+#include "weighted.h"
+#include "trace.h"
+#include "simulation.h"
+#include "sweep.h"
+#include "ensemble.h"
+#include "batch.h"
+#include "monitor.h"
+#include "memory.h"
 
 // global stuff
-gsl_rng *r;
-int Agent::id_counter = 0;
+__thread gsl_rng *r;
+__thread int Agent::id_counter = 0;
 
 int main(int argc, char *argv[])
 {
-  // "global" array of agents (size will be determined by command-line option)
-  Agent* population;
-  
-  // "global" list of links
-  list<Link> relation;
-
   // variables to hold simulation parameters:
   bool verbose = false;
+  bool homophily = false;
+  bool weighted_frequency = false;
+  bool weighted_stats = false;
+  bool sweep = false;
+  bool memory_report = false;
+  bool dry_run = false;
+  int nr_of_replicas = 0;
+  int nr_of_workers = 0;
+  const char* trace_file = NULL;
+  const char* socket_path = NULL;
+  string rule = "contrast";
   int population_size;
   int nr_of_links;
   int max_links;
@@ -33,20 +45,72 @@ int main(int argc, char *argv[])
   double assimilation_step;
   double link_treshold;
   
-  // filter out the -v option if it's there:
+  // filter out the options if they're there:
+  int nr_of_args = 1;
   for (int i=1; i<argc; i++)
   { 
-    if (verbose) argv[i-1] = argv[i];
     string option = argv[i];
     if (option == "-v") verbose = true;
+    else if (option == "-H") homophily = true;
+    else if (option == "-f") weighted_frequency = true;
+    else if (option == "-W") weighted_stats = true;
+    else if (option == "-S") sweep = true;
+    else if (option == "-M") memory_report = true;
+    else if (option == "--dry-run") dry_run = true;
+    else if (option == "-t" && i+1 < argc) trace_file = argv[++i];
+    else if (option == "-u" && i+1 < argc) socket_path = argv[++i];
+    else if (option == "-r" && i+1 < argc) rule = argv[++i];
+    else if (option == "-E" && i+1 < argc) nr_of_replicas = parseCount(argv[++i]);
+    else if (option == "-B" && i+1 < argc) nr_of_workers = parseCount(argv[++i]);
+    else argv[nr_of_args++] = argv[i];
   } 
-  if (verbose) argc--;
+  argc = nr_of_args;
+
+  // the accounting only works if it starts before anything is allocated,
+  // and is only reported for single runs (the other modes warn about -M
+  // later on, and shouldn't pay for the counting meanwhile)
+  bool single_run = !dry_run && nr_of_replicas == 0 && !sweep && nr_of_workers == 0;
+  if (memory_report && single_run && !Memory::enable())
+  {
+    cerr << "warning: Memory accounting could not be started, since memory was allocated already\n";
+    memory_report = false;
+  }
 
-  // show usage message if not correct nr. of arguments
-  if (argc != 6)
+  // show usage message if not correct nr. of arguments, an invalid count, or
+  // an ensemble combined with a sweep or batch
+  // (a dry run only needs the population size and the nr. of links)
+  if ( (argc != ((sweep || nr_of_workers > 0) ? 3 : 6) && !(dry_run && argc == 3))
+    || nr_of_replicas < 0 || nr_of_workers < 0
+    || (nr_of_replicas > 0 && (sweep || nr_of_workers > 0)) )
   {
-    cerr << "\nUsage: " << argv[0] << " [-v] pop_size nr_links ass_tres ass_step lnk_tres\n\n"
+    cerr << "\nUsage: " << argv[0] << " [-v] [-H] [-f] [-W] [-M] [-t file] [-u socket] [-r rule] [-E replicas] pop_size nr_links ass_tres ass_step lnk_tres\n"
+         << "       " << argv[0] << " -S [-B workers] [-v] [-H] [-f] [-r rule] pop_size nr_links\n"
+         << "       " << argv[0] << " -B workers [-v] [-H] [-f] [-r rule] pop_size nr_links\n"
+         << "       " << argv[0] << " --dry-run [-H] [-W] [-t file] [-E replicas | -B workers] pop_size nr_links [ass_tres ass_step lnk_tres]\n\n"
          << "      -v = Verbose; prints progress messages to STDERR\n"
+         << "      -H = Homophily; replaces removed links with links between agents\n"
+         << "           whose attributes lie within the link treshold\n"
+         << "      -f = Frequency; agents compare themselves to a peer with a probability\n"
+         << "           equal to the weight of their link\n"
+         << "      -W = Weighted; adds weighted network statistics to STDOUT\n"
+         << "      -M = Memory; prints the allocations and the peak and live heap bytes of\n"
+         << "           every phase and subsystem to STDERR\n"
+         << "--dry-run= Estimates the peak heap bytes of every subsystem from the\n"
+         << "           parameters, prints them to STDOUT and exits without simulating\n"
+         << "      -S = Sweep; runs an adaptive sweep over ass_tres, ass_step and lnk_tres\n"
+         << "           that refines the grid where the statistics change sharply\n"
+         << "-B work. = Batch; runs the grid of run.sh (or the runs of a sweep) in this\n"
+         << "           many worker processes, and prints all results to STDOUT\n"
+         << " -t file = Trace; writes every comparison and rewiring to a binary file\n"
+         << "-u sock. = Monitor; serves the progress of the run on this Unix domain socket\n"
+         << "-E repl. = Ensemble; runs this many replicas side by side and prints the mean,\n"
+         << "           standard deviation and 95% confidence interval of the statistics\n"
+         << " -r rule = Rule; the social comparison rule, one of:\n"
+         << "           contrast   = assimilate or contrast with a fixed step (default)\n"
+         << "           deffuant   = bounded confidence; both agents move towards each\n"
+         << "                        other if their difference is below ass_tres\n"
+         << "           continuous = assimilate or contrast with a step relative to\n"
+         << "                        the difference\n"
          << "pop_size = Population size\n"
          << "nr_links = Nr. of links (in the initial network)\n"
          << "ass_tres = Assimilation treshold: The minimum difference between two agents\n"
@@ -64,15 +128,36 @@ int main(int argc, char *argv[])
   population_size = atoi(argv[1]);
   nr_of_links = atoi(argv[2]);
   max_links = (population_size * (population_size-1)) / 2;
-  assimilation_treshold = atof(argv[3]);
-  assimilation_step = atof(argv[4]);
-  link_treshold = atof(argv[5]);
+  // (in a sweep or batch, these are chosen by the sweep or batch itself)
+  assimilation_treshold = (argc == 6) ? atof(argv[3]) : 0;
+  assimilation_step = (argc == 6) ? atof(argv[4]) : 0;
+  link_treshold = (argc == 6) ? atof(argv[5]) : 0;
   
   if (verbose) cerr << "Population size: " << population_size << endl
                     << "Nr. of links: " << nr_of_links << endl
                     << "Assimilation treshold: " << assimilation_treshold << endl
                     << "Assimilation step: " << assimilation_step << endl
-                    << "Link treshold: " << link_treshold << endl;
+                    << "Link treshold: " << link_treshold << endl
+                    << "Homophilous rewiring: " << (homophily ? "yes" : "no") << endl
+                    << "Weighted comparison frequency: " << (weighted_frequency ? "yes" : "no") << endl
+                    << "Comparison rule: " << rule << endl;
+
+  Parameters parameters;
+  parameters.population_size = population_size;
+  parameters.nr_of_links = nr_of_links;
+  parameters.assimilation_treshold = assimilation_treshold;
+  parameters.assimilation_step = assimilation_step;
+  parameters.link_treshold = link_treshold;
+  parameters.weighted_frequency = weighted_frequency;
+
+  if (rule == "contrast") parameters.rule = RULE_CONTRAST;
+  else if (rule == "deffuant") parameters.rule = RULE_DEFFUANT;
+  else if (rule == "continuous") parameters.rule = RULE_CONTINUOUS;
+  else
+  {
+    cerr << "fatal error: Unknown comparison rule (" << rule << ")\n";
+    exit(1);
+  }
    
   // check if the number of links doesn't exceed n(n-1)/2
   if ( nr_of_links > max_links )
@@ -82,6 +167,22 @@ int main(int argc, char *argv[])
     exit(1);
   }
 
+  // homophilous rewiring needs some room between attributes
+  if ( homophily && argc == 6 && link_treshold <= 0 )
+  {
+    cerr << "warning: Homophilous rewiring needs a positive link treshold, using random rewiring\n";
+    homophily = false;
+  }
+  parameters.homophily = homophily;
+
+  // estimate the footprint before anything is allocated for the simulation
+  if (dry_run)
+  {
+    int nr_of_runs = (nr_of_replicas > 0) ? nr_of_replicas : (nr_of_workers > 0) ? nr_of_workers : 1;
+    Memory::estimate(parameters, weighted_stats, trace_file != NULL, nr_of_runs);
+    exit(0);
+  }
+
   if (verbose) cerr << "Initializing random number generator...\n";
   
   // initialize the random number generator:
@@ -89,122 +190,134 @@ int main(int argc, char *argv[])
   if (verbose) cerr << "Using seed: " << seed << endl;
   r = gsl_rng_alloc(gsl_rng_mt19937); // aka the 'Mersenne Twister'
   gsl_rng_set(r, seed);
-  
-  if (verbose) cerr << "Allocating memory for agents...\n";
-  
-  // reserve heap memory for the agent objects
-  population = new Agent[population_size];
+
+  if (nr_of_replicas > 0)
+  {
+    if (trace_file) cerr << "warning: The event trace is not available for ensembles\n";
+    if (weighted_stats) cerr << "warning: Weighted statistics are not available for ensembles\n";
+    if (socket_path) cerr << "warning: The progress monitor is not available for ensembles\n";
+    if (memory_report) cerr << "warning: Memory accounting is not available for ensembles, use --dry-run instead\n";
+    runEnsemble(parameters, nr_of_replicas, seed, verbose);
+    exit(0);
+  }
+
+  if (socket_path && (sweep || nr_of_workers > 0))
+  {
+    cerr << "warning: The progress monitor is not available for sweeps and batches\n";
+  }
+  if (memory_report && (sweep || nr_of_workers > 0))
+  {
+    cerr << "warning: Memory accounting is not available for sweeps and batches, use --dry-run instead\n";
+  }
+  if (trace_file && (sweep || nr_of_workers > 0))
+  {
+    cerr << "warning: The event trace is not available for sweeps and batches\n";
+  }
+  if (weighted_stats && (sweep || nr_of_workers > 0))
+  {
+    cerr << "warning: Weighted statistics are not available for sweeps and batches\n";
+  }
+
+  if (sweep)
+  {
+    if (verbose) cerr << "Starting adaptive parameter sweep...\n";
+    adaptiveSweep(parameters, nr_of_workers, seed, verbose);
+    exit(0);
+  }
+
+  if (nr_of_workers > 0)
+  {
+    if (verbose) cerr << "Starting batch of simulations...\n";
+    runGrid(parameters, nr_of_workers, seed, verbose);
+    exit(0);
+  }
   
   if (verbose) cerr << "Creating random social network according to Erdős-Rényi (1959) model";
   if (verbose) cerr << "\n(by picking " << nr_of_links << " random links from n(n-1)/2 = " << max_links << " possible links)";
   if (verbose) cerr << "...\n";
-  
-  Agent* random_agent1;
-  Agent* random_agent2;
 
-  // create some random links between agents:
-  for (int i=0; i<nr_of_links; i++)
+  if (memory_report) Memory::phase("network");
+  Simulation simulation(parameters);
+  Agent* population = simulation.getPopulation();
+
+  if (verbose) cerr << "Successfully created random network!\n";
+  if (memory_report) Memory::phase("iteration");
+
+  // start the background writer of the event trace
+  if (trace_file)
   {
-    do
-    { // assign both pointers the address of a random agent:
-      random_agent1 = &population[ gsl_rng_uniform_int(r,population_size) ];
-      random_agent2 = &population[ gsl_rng_uniform_int(r,population_size) ];
-      if (DEBUG) cerr << "Linking agent " << random_agent1->getid() << " to agent " << random_agent2->getid() << "...\n";
-    }
-    // retry if both agents are the same or if they are already linked:
-    while ( !validLink(random_agent1, random_agent2, relation) );
-    
-    // add the link object to the linklist:
-    relation.push_back(Link(random_agent1,random_agent2));
-    // NOTE: in the above, the call to the Link constructor returns a value of the class type.
-    // When this happens, the copy constructor is invoked, which updates both agents' link
-    // lists so that they point to the address of the new (copied) link object.
-    // It would be easier if the constructor simply returned a reference...
+    if (verbose) cerr << "Writing event trace to " << trace_file << "...\n";
+    if (!Trace::open(trace_file)) exit(1);
   }
-  
-  if (verbose) cerr << "Successfully created random network!\n";
-  
+
+  // start the background server of the progress monitor
+  if (socket_path)
+  {
+    if (verbose) cerr << "Serving progress on " << socket_path << "...\n";
+    if (!Monitor::open(socket_path, population_size)) exit(1);
+  }
+
   if (verbose) cerr << "Proceeding with updating the network by social psychological processes...\n";
     
   // now let the fun begin!
   cerr << "#Iteration Removed Links         Density    Cluster.   Assort.\n";
-  int i = 0;
-  int removed = 0;
   do
   { 
     // print the stats:
-    fprintf (stderr, "%-11d", i++);
-    fprintf (stderr, "%-22d", removed);
-    fprintf (stderr, "%-11.2f", relation.size() / static_cast<double>(max_links));
-    fprintf (stderr, "%-11.2f", clustering(population_size, population, relation));
-    fprintf (stderr, "%-11.2f", assortativity(relation));
-    // fprintf (stderr, "%-11.2f", avgpath(population_size, population));
+    Stats stats = simulation.getStats(false);
+    fprintf (stderr, "%-11d", stats.iterations);
+    fprintf (stderr, "%-22d", stats.removed);
+    fprintf (stderr, "%-11.2f", stats.density);
+    fprintf (stderr, "%-11.2f", stats.clustering);
+    fprintf (stderr, "%-11.2f", stats.assortativity);
     cerr << endl;
+    if (Monitor::isOpen()) Monitor::publish(stats);
     
-    // loop over all agents:
-    for (int j=0; j<population_size; j++)
-    { 
-      // loop over all its peers
-      list<Agent*> peers = population[j].getAgents();
-      list<Agent*>::iterator it;
-      for (it=peers.begin(); it!=peers.end(); it++)
-      {
-        Agent* agent = &population[j];
-        Agent* peer = *it;
-        
-        // the agent makes a social comparison with this peer and adjusts its attribute:
-        agent->compare(peer, assimilation_treshold, assimilation_step);
-        
-        // calculate the attribute difference after this adjustment...
-        double difference = abs(agent->getattr() - peer->getattr());
-      
-        // ... and replace it with a random link if it exceeds the link treshold
-        if (difference > link_treshold)
-        {
-          if (DEBUG) cerr << "Link treshold (" << link_treshold << ") exceeded. Removing the link between agents " << agent->getid() << " and " << peer->getid() << "...\n";
-          removeLink(agent, peer, relation);
-          removed++;
-
-          // REMOVE THE FOLLOWING TO PREVENT AUTOMATIC NEW LINKS
-          do
-          { // assign both pointers the address of a random agent:
-            random_agent1 = &population[ gsl_rng_uniform_int(r,population_size) ];
-            random_agent2 = &population[ gsl_rng_uniform_int(r,population_size) ];
-          }
-          // retry if both agents are the same or if they are already linked:
-          while ( !validLink(random_agent1, random_agent2, relation) );
+    // let the active agents compare themselves to their peers:
+    simulation.iterate();
+    
+  } while ( simulation.getIteration() <= MAXIMUM_ITERATIONS && !simulation.isQuiescent() ); // (or until nothing changes)
 
-          // add the link object to the linklist:
-          relation.push_back(Link(random_agent1,random_agent2));
+  if (verbose && simulation.isQuiescent()) cerr << "The network is stable after " << simulation.getIteration() << " iterations.\n";
 
-        }
-        else
-        {
-          if (DEBUG) cerr << "Link treshold (" << link_treshold << ") not exceeded. Keeping the link between agents " << agent->getid() << " and " << peer->getid() << endl;
-        }
-      }
-    }
-    
-  } while ( i <= MAXIMUM_ITERATIONS );
+  Trace::close();
+  Monitor::close();
   
   if (verbose) cerr << "Sending results to STDOUT...\n";
+  if (memory_report) Memory::phase("statistics");
 
   // print model parameters and final network statistics
-  cout << "pop_size nr_links ass_tres ass_step lnk_tres itrtions rel_size density  clustrng assrtvty avgpath\n";
+  cout << "pop_size nr_links ass_tres ass_step lnk_tres itrtions rel_size density  clustrng assrtvty avgpath";
+  if (weighted_stats) cout << "  wclust_b wclust_o s_assort wavgpath";
+  cout << endl;
   printf ("%-9d", population_size);
   printf ("%-9d", nr_of_links);
   printf ("%-9.2f", assimilation_treshold);
   printf ("%-9.2f", assimilation_step);
   printf ("%-9.2f", link_treshold);
-  printf ("%-9d",i);
-  printf ("%-9d",relation.size());
-  printf ("%-9.2f",relation.size() / static_cast<double>(max_links));
-  printf ("%-9.2f",clustering(population_size, population, relation));
-  printf ("%-9.2f",assortativity(relation));
-  printf ("%-9.2f", avgpath(population_size, population));
+  Stats stats = simulation.getStats(true);
+  printf ("%-9d",stats.iterations);
+  printf ("%-9d",stats.links);
+  printf ("%-9.2f",stats.density);
+  printf ("%-9.2f",stats.clustering);
+  printf ("%-9.2f",stats.assortativity);
+  printf ("%-9.2f",stats.avgpath);
+
+  if (weighted_stats)
+  {
+    if (verbose) cerr << "Calculating weighted network statistics...\n";
+    Memory::Scope scope(MEMORY_SCRATCH);
+    WeightedGraph graph(population_size, population);
+    printf ("%-9.2f", graph.clusteringBarrat());
+    printf ("%-9.2f", graph.clusteringOnnela());
+    printf ("%-9.2f", graph.assortativity());
+    printf ("%-9.2f", graph.avgpath());
+  }
 
   cout << endl;
 
+  if (memory_report) Memory::report();
+
   // calculate assortativity
 //  printf ("Assortativity: %-11.2f\n", assortativity(relation));
 
@@ -220,6 +333,21 @@ int main(int argc, char *argv[])
 
 
 
+int parseCount(const char* text)
+// returns the positive integer in the text, or -1 if it isn't one
+{
+  char* end;
+  long count = strtol(text, &end, 10);
+  if (end == text || *end != '\0' || count <= 0 || count > 1000000) return -1;
+  return count;
+}
+
+
+
+/*****************************************************************************/
+
+
+
 bool validLink(Agent* agent1, Agent* agent2, list<Link> &relation)
 // returns false if the Agents are the same or already linked
 // (does not presuppose that the lowest agent is always source)
@@ -286,6 +414,41 @@ void removeLink(Agent* agent1, Agent* agent2, list<Link> &relation)
 
 
 
+void addSimilarLink(int nr_of_agents, Agent population[], AttributeIndex &index, list<Link> &relation)
+// adds a link between a random agent and an agent with a similar attribute
+{
+  Agent* agent1;
+  Agent* agent2;
+
+  // try a number of random agents before giving up on homophily:
+  for (int attempt=0; attempt<nr_of_agents; attempt++)
+  {
+    agent1 = &population[ gsl_rng_uniform_int(r,nr_of_agents) ];
+    agent2 = index.getSimilar(agent1);
+    if (validLink(agent1, agent2, relation))
+    {
+      relation.push_back(Link(agent1,agent2));
+      return;
+    }
+  }
+
+  // this only happens when nearly all similar agents are already linked
+  if (DEBUG) cerr << "No similar agents left to link, picking a random link instead...\n";
+  do
+  {
+    agent1 = &population[ gsl_rng_uniform_int(r,nr_of_agents) ];
+    agent2 = &population[ gsl_rng_uniform_int(r,nr_of_agents) ];
+  }
+  while ( !validLink(agent1, agent2, relation) );
+  relation.push_back(Link(agent1,agent2));
+}
+
+
+
+/*****************************************************************************/
+
+
+
 void printXML(int nr_of_agents, list<Link> &relation)
 // prints output in GraphML format
 {
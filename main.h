@@ -6,22 +6,28 @@ main.h: contains all forward declarations and necessary includes
 #define MAIN_H
 
 #define DEBUG false
+#define MAXIMUM_ITERATIONS 25
 
 #include <cstdlib>
 #include <iostream>
 #include <string>   
 #include <cmath>
 #include <list>
+#include <vector>
 #include <ctime>
 #include <unistd.h>
 #include <gsl/gsl_rng.h>
 
 using namespace std;
 
-extern gsl_rng *r; // global random number generator:
+extern __thread gsl_rng *r; // global random number generator (one per thread):
 
 class Agent; // a thinking human agent
 class Link; // a link between two agents
+class AttributeIndex; // agents sorted by attribute
+
+int parseCount(const char* text);
+// returns the positive integer in the text, or -1 if it isn't one
 
 bool validLink(Agent* agent1, Agent* agent2, list<Link> &relation);
 // returns false if the Agents are the same or already linked
@@ -29,6 +35,9 @@ bool validLink(Agent* agent1, Agent* agent2, list<Link> &relation);
 void removeLink(Agent* agent1, Agent* agent2, list<Link> &relation);
 // searches for and removes the link between two agents
 
+void addSimilarLink(int nr_of_agents, Agent population[], AttributeIndex &index, list<Link> &relation);
+// adds a link between a random agent and an agent with a similar attribute
+
 void printXML(int nr_of_agents, list<Link> &relation);
 // prints XML output
 
@@ -0,0 +1,339 @@
+/*
+memory.cpp: the implementation of the heap accounting
+*/
+
+#include "main.h"
+#include "agent.h"
+#include "link.h"
+#include "trace.h"
+#include "attrindex.h"
+#include "simulation.h"
+#include "memory.h"
+
+#include <cstdio>
+#include <algorithm>
+#include <new>
+#include <malloc.h>
+
+// the header in front of every counted block: its size and subsystem
+// (16 bytes, so that the block itself stays aligned for any type)
+#define MEMORY_HEADER 16
+
+struct Account
+{
+  long allocations; // the nr. of allocations in the current phase
+  long live; // the bytes in use now
+  long peak; // the most bytes in use at once in the current phase
+};
+
+struct PhaseRecord
+{
+  const char* name;
+  Account accounts[NR_OF_SUBSYSTEMS + 1]; // the last one is the total
+};
+
+bool Memory::counting = false;
+__thread MemorySubsystem Memory::current = MEMORY_OTHER;
+
+static bool started = false; // whether anything was allocated already
+static Account accounts[NR_OF_SUBSYSTEMS + 1];
+static PhaseRecord phases[MEMORY_PHASES];
+static int nr_of_phases = 0;
+static const char* phase_name = NULL;
+
+static const char* subsystem_names[] = { "other", "graph", "scratch", "output", "total" };
+
+
+
+static void count(Account &account, long bytes)
+// adds (or with negative bytes, subtracts) a block to an account
+{
+  long live = __atomic_add_fetch(&account.live, bytes, __ATOMIC_RELAXED);
+  if (bytes > 0) __atomic_add_fetch(&account.allocations, 1, __ATOMIC_RELAXED);
+
+  long peak = __atomic_load_n(&account.peak, __ATOMIC_RELAXED);
+  while (live > peak && !__atomic_compare_exchange_n(&account.peak, &peak, live, true, __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+}
+
+
+
+void* Memory::allocate(size_t size)
+// the implementation of operator new
+{
+  if (!counting)
+  {
+    if (!__atomic_load_n(&started, __ATOMIC_RELAXED)) __atomic_store_n(&started, true, __ATOMIC_RELAXED);
+    void* pointer = malloc(size ? size : 1);
+    if (!pointer) throw bad_alloc();
+    return pointer;
+  }
+
+  char* block = static_cast<char*>(malloc(size + MEMORY_HEADER));
+  if (!block) throw bad_alloc();
+
+  // count the bytes that malloc really set aside, header included
+  long bytes = malloc_usable_size(block);
+  MemorySubsystem subsystem = current;
+  *reinterpret_cast<long*>(block) = bytes;
+  *reinterpret_cast<int*>(block + sizeof(long)) = subsystem;
+
+  count(accounts[subsystem], bytes);
+  count(accounts[NR_OF_SUBSYSTEMS], bytes);
+  return block + MEMORY_HEADER;
+}
+
+
+
+void Memory::release(void* pointer)
+// the implementation of operator delete
+{
+  if (!pointer) return;
+  if (!counting)
+  {
+    free(pointer);
+    return;
+  }
+
+  char* block = static_cast<char*>(pointer) - MEMORY_HEADER;
+  long bytes = *reinterpret_cast<long*>(block);
+  int subsystem = *reinterpret_cast<int*>(block + sizeof(long));
+
+  count(accounts[subsystem], -bytes);
+  count(accounts[NR_OF_SUBSYSTEMS], -bytes);
+  free(block);
+}
+
+
+
+bool Memory::enable()
+// starts the accounting; returns false if something was allocated already
+{
+  if (counting) return true;
+  if (started) return false;
+  counting = true;
+  return true;
+}
+
+
+
+static void closePhase()
+// stores the accounts of the current phase, if there is one
+{
+  if (!phase_name || nr_of_phases >= MEMORY_PHASES) return;
+  phases[nr_of_phases].name = phase_name;
+  for (int s=0; s<=NR_OF_SUBSYSTEMS; s++)
+  {
+    phases[nr_of_phases].accounts[s].allocations = __atomic_load_n(&accounts[s].allocations, __ATOMIC_RELAXED);
+    phases[nr_of_phases].accounts[s].live = __atomic_load_n(&accounts[s].live, __ATOMIC_RELAXED);
+    phases[nr_of_phases].accounts[s].peak = __atomic_load_n(&accounts[s].peak, __ATOMIC_RELAXED);
+  }
+  nr_of_phases++;
+}
+
+
+
+void Memory::phase(const char* name)
+// ends the current phase (if any) and starts a new one
+{
+  if (!counting) return;
+  closePhase();
+
+  // the new phase starts counting from what is in use now
+  for (int s=0; s<=NR_OF_SUBSYSTEMS; s++)
+  {
+    __atomic_store_n(&accounts[s].allocations, 0, __ATOMIC_RELAXED);
+    __atomic_store_n(&accounts[s].peak, __atomic_load_n(&accounts[s].live, __ATOMIC_RELAXED), __ATOMIC_RELAXED);
+  }
+  phase_name = name;
+}
+
+
+
+void Memory::report()
+// ends the current phase and prints the accounting of all phases to STDERR
+{
+  if (!counting) return;
+  closePhase();
+  phase_name = NULL;
+
+  long peak = 0;
+  cerr << "#Phase     Subsystem  Allocs     Peak bytes   Live bytes\n";
+  for (int p=0; p<nr_of_phases; p++)
+  {
+    for (int s=0; s<=NR_OF_SUBSYSTEMS; s++)
+    {
+      Account &account = phases[p].accounts[s];
+
+      // leave out the subsystems that had nothing to do with this phase
+      if (s < NR_OF_SUBSYSTEMS && !account.allocations && !account.peak) continue;
+
+      fprintf (stderr, "%-11s", phases[p].name);
+      fprintf (stderr, "%-11s", subsystem_names[s]);
+      fprintf (stderr, "%-11ld", account.allocations);
+      fprintf (stderr, "%-13ld", account.peak);
+      fprintf (stderr, "%-13ld", account.live);
+      cerr << endl;
+    }
+    if (phases[p].accounts[NR_OF_SUBSYSTEMS].peak > peak) peak = phases[p].accounts[NR_OF_SUBSYSTEMS].peak;
+  }
+  fprintf (stderr, "#Peak of the run: %ld bytes (%.1f MiB)\n", peak, peak / 1048576.0);
+}
+
+
+
+/*****************************************************************************/
+
+
+
+static long heapBytes(size_t size)
+// returns the bytes that the accounting counts for an allocation of this
+// size; glibc's malloc rounds every chunk to 16 bytes, of which it keeps 8
+{
+  size_t chunk = (size + MEMORY_HEADER + 8 + 15) & ~static_cast<size_t>(15);
+  if (chunk < 32) chunk = 32;
+  return chunk - 8;
+}
+
+
+
+static size_t grown(size_t size)
+// returns the capacity of a vector that grew to this size by push_back
+{
+  size_t capacity = 1;
+  while (capacity < size) capacity *= 2;
+  return capacity;
+}
+
+
+
+template <class T>
+static long listNode()
+// returns the bytes that one element of a list<T> takes
+{
+  return heapBytes(2 * sizeof(void*) + sizeof(T));
+}
+
+
+
+void Memory::estimate(const Parameters &parameters, bool weighted_stats, bool trace, int nr_of_runs)
+// prints the expected peak heap bytes of each subsystem and phase, and
+// of the whole run, to STDOUT without allocating anything
+{
+  double n = parameters.population_size;
+  double links = parameters.nr_of_links;
+  double degree = 2 * links / n;
+  long estimate[NR_OF_SUBSYSTEMS + 1] = { 0 };
+
+  // the agents, the links and the agents' lists of links; rewiring keeps
+  // the nr. of links constant
+  estimate[MEMORY_GRAPH] += heapBytes(parameters.population_size * sizeof(Agent) + sizeof(size_t));
+  estimate[MEMORY_GRAPH] += static_cast<long>(links * listNode<Link>());
+  estimate[MEMORY_GRAPH] += static_cast<long>(2 * links * listNode<Link*>());
+  if (parameters.homophily)
+  { // the buckets, their agents (with room to grow) and the positions of the agents;
+    // without a link treshold, assume the worst case of a bucket per agent
+    int nr_of_buckets = (parameters.link_treshold > 0)
+      ? AttributeIndex::nrOfBuckets(parameters.population_size, parameters.link_treshold)
+      : parameters.population_size;
+    estimate[MEMORY_GRAPH] += heapBytes(nr_of_buckets * sizeof(vector<Agent*>));
+    estimate[MEMORY_GRAPH] += nr_of_buckets * heapBytes(static_cast<size_t>(2 * n / nr_of_buckets) * sizeof(Agent*));
+    estimate[MEMORY_GRAPH] += 2 * heapBytes(parameters.population_size * sizeof(int));
+  }
+
+  // the flags of the active agents, and the lists of this and the next sweep
+  estimate[MEMORY_GRAPH] += heapBytes(parameters.population_size / 8 + sizeof(long));
+  estimate[MEMORY_GRAPH] += 2 * heapBytes(parameters.population_size * sizeof(int));
+
+  // during the iterations, the clustering of the progress table copies the
+  // peers of an agent and of one of its peers; take a generous maximum degree
+  double max_degree = degree + 4 * sqrt(degree) + 4;
+  long iteration_scratch = static_cast<long>(3 * max_degree * listNode<Agent*>());
+
+  // in the final statistics, the average path length is the largest user of
+  // temporary lists: the visited list holds every reached agent about twice,
+  // next to the queues and the peers of the agent that is being visited
+  long statistics_scratch = static_cast<long>((3 * n + degree) * listNode<Agent*>());
+  if (weighted_stats)
+  { // the snapshot of the weighted graph, plus the distances and heap of every thread
+    long snapshot = heapBytes((parameters.population_size + 1) * sizeof(int))
+                  + heapBytes(grown(2 * parameters.nr_of_links) * sizeof(int))
+                  + heapBytes(grown(2 * parameters.nr_of_links) * sizeof(double))
+                  + heapBytes(parameters.population_size * sizeof(double));
+    long nr_of_threads = sysconf(_SC_NPROCESSORS_ONLN);
+    if (nr_of_threads < 1) nr_of_threads = 1;
+    long per_thread = heapBytes(parameters.population_size * sizeof(double))
+                    + heapBytes((2 * parameters.nr_of_links + 1) * sizeof(pair<double,int>));
+    long weighted = snapshot + nr_of_threads * per_thread;
+    if (weighted > statistics_scratch) statistics_scratch = weighted;
+  }
+  estimate[MEMORY_SCRATCH] = max(iteration_scratch, statistics_scratch);
+
+  // the ring buffer of the event trace; it is freed before the final statistics
+  if (trace) estimate[MEMORY_OUTPUT] += heapBytes(sizeof(TraceBuffer));
+
+  // the subsystems peak in different phases, so the peak of the run is the
+  // largest sum within one phase, not the sum of the peaks
+  long phase_estimates[3];
+  phase_estimates[0] = estimate[MEMORY_GRAPH];
+  phase_estimates[1] = estimate[MEMORY_GRAPH] + iteration_scratch + estimate[MEMORY_OUTPUT];
+  phase_estimates[2] = estimate[MEMORY_GRAPH] + statistics_scratch;
+  const char* phase_names[] = { "network", "iteration", "statistics" };
+  estimate[NR_OF_SUBSYSTEMS] = *max_element(phase_estimates, phase_estimates + 3);
+
+  cout << "estimate   peak_bytes   peak_mib\n";
+  for (int s=MEMORY_GRAPH; s<NR_OF_SUBSYSTEMS; s++)
+  {
+    printf ("%-11s", subsystem_names[s]);
+    printf ("%-13ld", estimate[s]);
+    printf ("%-9.1f", estimate[s] / 1048576.0);
+    cout << endl;
+  }
+  for (int p=0; p<3; p++)
+  {
+    printf ("%-11s", phase_names[p]);
+    printf ("%-13ld", phase_estimates[p]);
+    printf ("%-9.1f", phase_estimates[p] / 1048576.0);
+    cout << endl;
+  }
+  printf ("%-11s", subsystem_names[NR_OF_SUBSYSTEMS]);
+  printf ("%-13ld", estimate[NR_OF_SUBSYSTEMS]);
+  printf ("%-9.1f", estimate[NR_OF_SUBSYSTEMS] / 1048576.0);
+  cout << endl;
+  if (nr_of_runs > 1)
+  {
+    long all = estimate[NR_OF_SUBSYSTEMS] * nr_of_runs;
+    printf ("%-11s", "x runs");
+    printf ("%-13ld", all);
+    printf ("%-9.1f", all / 1048576.0);
+    printf ("(%d runs at once)", nr_of_runs);
+    cout << endl;
+  }
+}
+
+
+
+/*****************************************************************************/
+
+
+
+void* operator new(size_t size) { return Memory::allocate(size); }
+void* operator new[](size_t size) { return Memory::allocate(size); }
+void operator delete(void* pointer) throw() { Memory::release(pointer); }
+void operator delete[](void* pointer) throw() { Memory::release(pointer); }
+void operator delete(void* pointer, size_t) throw() { Memory::release(pointer); }
+void operator delete[](void* pointer, size_t) throw() { Memory::release(pointer); }
+
+void* operator new(size_t size, const nothrow_t&) throw()
+{
+  try { return Memory::allocate(size); }
+  catch (bad_alloc&) { return NULL; }
+}
+
+void* operator new[](size_t size, const nothrow_t&) throw()
+{
+  try { return Memory::allocate(size); }
+  catch (bad_alloc&) { return NULL; }
+}
+
+void operator delete(void* pointer, const nothrow_t&) throw() { Memory::release(pointer); }
+void operator delete[](void* pointer, const nothrow_t&) throw() { Memory::release(pointer); }
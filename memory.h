@@ -0,0 +1,70 @@
+/*
+memory.h: interface of the heap accounting
+
+With accounting enabled, every allocation through operator new is counted
+against the subsystem of the scope it was made in, and the number of
+allocations, the live bytes and the peak bytes of every subsystem are kept
+per phase of the run. Accounting has to be enabled before the first
+allocation, since only then every block carries the small header that tells
+its size and subsystem when it is freed.
+*/
+
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include "main.h"
+
+#define MEMORY_PHASES 8 // the maximum nr. of phases that are reported
+
+enum MemorySubsystem
+{
+  MEMORY_OTHER = 0,   // anything that wasn't allocated in a tagged scope
+  MEMORY_GRAPH = 1,   // the agents, the links, the agents' link lists and the attribute index
+  MEMORY_SCRATCH = 2, // temporary lists and arrays of the comparisons and statistics
+  MEMORY_OUTPUT = 3,  // the buffers of the event trace and the progress monitor
+  NR_OF_SUBSYSTEMS = 4
+};
+
+struct Parameters;
+
+class Memory
+{
+public:
+
+  static bool enable();
+  // starts the accounting; returns false if something was allocated already
+
+  static bool isEnabled() { return counting; }
+
+  static void phase(const char* name);
+  // ends the current phase (if any) and starts a new one
+
+  static void report();
+  // ends the current phase and prints the accounting of all phases to STDERR
+
+  static void estimate(const Parameters &parameters, bool weighted_stats, bool trace, int nr_of_runs);
+  // prints the expected peak heap bytes of each subsystem and phase, and
+  // of the whole run, to STDOUT without allocating anything
+
+  static void* allocate(size_t size);
+  static void release(void* pointer);
+  // the implementation of operator new and delete
+
+  // tags all allocations of this thread with a subsystem while it exists:
+  class Scope
+  {
+  public:
+    Scope(MemorySubsystem subsystem) : previous(current) { current = subsystem; }
+    ~Scope() { current = previous; }
+
+  private:
+    MemorySubsystem previous;
+  };
+
+private:
+  static bool counting;
+  static __thread MemorySubsystem current; // one per thread, like the random number generator
+};
+
+#endif
+// MEMORY_H
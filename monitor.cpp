@@ -0,0 +1,212 @@
+/*
+monitor.cpp: the implementation of the progress monitor
+*/
+
+#include "main.h"
+#include "monitor.h"
+#include "memory.h"
+
+#include <cstdio>
+#include <cstring>
+#include <pthread.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+bool Monitor::enabled = false;
+Monitor::Progress Monitor::current = { 0, 0, 0, 0 };
+
+static int listener = -1;
+static string socket_path;
+static pthread_t thread;
+static bool stopping = false;
+static int nr_of_agents = 0;
+static double start_time = 0;
+
+// the latest stats, guarded by a sequence lock: the writer makes the
+// sequence odd while it is busy, and readers retry until it is even
+static unsigned int sequence = 0;
+static Stats latest;
+
+// the previous snapshot, to calculate the recent throughput
+static double last_time = 0;
+static long last_comparisons = 0;
+
+
+
+static double now()
+// returns the number of seconds on a monotonic clock
+{
+  struct timespec time;
+  clock_gettime(CLOCK_MONOTONIC, &time);
+  return time.tv_sec + time.tv_nsec / 1e9;
+}
+
+
+
+bool Monitor::open(const char* path, int population_size)
+// creates the socket and starts the background server thread
+{
+  Memory::Scope scope(MEMORY_OUTPUT);
+  struct sockaddr_un address;
+  if (strlen(path) >= sizeof(address.sun_path))
+  {
+    cerr << "error: The socket path " << path << " is too long\n";
+    return false;
+  }
+
+  // remove the socket of a previous run, but nothing else
+  struct stat info;
+  if (lstat(path, &info) == 0 && S_ISSOCK(info.st_mode)) unlink(path);
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, path);
+
+  listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (listener < 0
+   || bind(listener, reinterpret_cast<struct sockaddr*>(&address), sizeof(address)) != 0
+   || listen(listener, 8) != 0)
+  {
+    cerr << "error: Could not create the socket " << path << ": " << strerror(errno) << endl;
+    if (listener >= 0) ::close(listener);
+    return false;
+  }
+
+  socket_path = path;
+  nr_of_agents = population_size;
+  start_time = last_time = now();
+  stopping = false;
+  if (pthread_create(&thread, NULL, server, NULL) != 0)
+  {
+    cerr << "error: Could not start the monitor thread\n";
+    ::close(listener);
+    unlink(path);
+    return false;
+  }
+  enabled = true;
+  return true;
+}
+
+
+
+void Monitor::close()
+// stops the server thread and removes the socket
+{
+  if (!enabled) return;
+  enabled = false;
+
+  __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+  pthread_join(thread, NULL);
+  ::close(listener);
+  unlink(socket_path.c_str());
+}
+
+
+
+void Monitor::publish(const Stats &stats)
+// stores the latest statistics of the network; never blocks
+{
+  unsigned int s = sequence;
+  __atomic_store_n(&sequence, s + 1, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  latest = stats;
+  __atomic_store_n(&sequence, s + 2, __ATOMIC_RELEASE);
+}
+
+
+
+void* Monitor::server(void*)
+// the background thread that answers the clients
+{
+  struct pollfd request;
+  request.fd = listener;
+  request.events = POLLIN;
+
+  while (!__atomic_load_n(&stopping, __ATOMIC_ACQUIRE))
+  {
+    // wake up regularly to see if it's time to stop
+    if (poll(&request, 1, 200) <= 0) continue;
+
+    int client = accept(listener, NULL, NULL);
+    if (client < 0) continue;
+    snapshot(client);
+    ::close(client);
+  }
+  return NULL;
+}
+
+
+
+void Monitor::snapshot(int client)
+// writes the current progress and the latest stats to a client
+{
+  Progress progress;
+  progress.iteration = __atomic_load_n(&current.iteration, __ATOMIC_RELAXED);
+  progress.agents_done = __atomic_load_n(&current.agents_done, __ATOMIC_RELAXED);
+  progress.comparisons = __atomic_load_n(&current.comparisons, __ATOMIC_RELAXED);
+  progress.removed = __atomic_load_n(&current.removed, __ATOMIC_RELAXED);
+
+  Stats stats;
+  unsigned int before, after;
+  do
+  {
+    before = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE);
+    stats = latest;
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    after = __atomic_load_n(&sequence, __ATOMIC_RELAXED);
+  } while ((before & 1) || before != after);
+
+  double time = now();
+  double elapsed = time - start_time;
+  double recent = time - last_time;
+  double recent_rate = (recent > 0) ? (progress.comparisons - last_comparisons) / recent : 0;
+  last_time = time;
+  last_comparisons = progress.comparisons;
+
+  char buffer[1024];
+  int length = snprintf(buffer, sizeof(buffer),
+    "iteration %d\n"
+    "max_iterations %d\n"
+    "agents_done %d\n"
+    "population_size %d\n"
+    "sweep_progress %.4f\n"
+    "elapsed_seconds %.1f\n"
+    "comparisons %ld\n"
+    "comparisons_per_second %.0f\n"
+    "recent_comparisons_per_second %.0f\n"
+    "removed %ld\n"
+    "removed_per_second %.1f\n"
+    "removed_per_comparison %.4f\n",
+    progress.iteration, MAXIMUM_ITERATIONS + 1,
+    progress.agents_done, nr_of_agents,
+    nr_of_agents ? progress.agents_done / static_cast<double>(nr_of_agents) : 0,
+    elapsed,
+    progress.comparisons,
+    (elapsed > 0) ? progress.comparisons / elapsed : 0,
+    recent_rate,
+    progress.removed,
+    (elapsed > 0) ? progress.removed / elapsed : 0,
+    progress.comparisons ? progress.removed / static_cast<double>(progress.comparisons) : 0);
+
+  // the stats are only there after the first row of the progress table
+  if (after > 0)
+  {
+    length += snprintf(buffer + length, sizeof(buffer) - length,
+      "stats_iteration %d\n"
+      "links %d\n"
+      "density %.4f\n"
+      "clustering %.4f\n"
+      "assortativity %.4f\n",
+      stats.iterations, stats.links, stats.density, stats.clustering, stats.assortativity);
+  }
+
+  // the client may have gone already, so don't let that raise a SIGPIPE
+  for (int written=0; written < length; )
+  {
+    int result = send(client, buffer + written, length - written, MSG_NOSIGNAL);
+    if (result <= 0) break;
+    written += result;
+  }
+}
@@ -0,0 +1,69 @@
+/*
+monitor.h: interface of the progress monitor
+
+The monitor serves the progress of a running simulation over a local Unix
+domain socket. Every client that connects gets a snapshot of the progress
+as "name value" lines, after which the connection is closed, e.g.:
+
+    socat - UNIX-CONNECT:unet.sock
+
+The simulation thread only stores a few numbers in memory; formatting and
+writing the snapshots is done by a background thread. Runs without a monitor
+use the NoMonitor policy instead, so their inner loop doesn't even check.
+*/
+
+#ifndef MONITOR_H
+#define MONITOR_H
+
+#include "main.h"
+#include "simulation.h"
+
+class Monitor
+{
+public:
+
+  static bool open(const char* path, int population_size);
+  // creates the socket and starts the background server thread
+
+  static void close();
+  // stops the server thread and removes the socket
+
+  static bool isOpen() { return enabled; }
+
+  // stores the progress within the current iteration; never blocks:
+  static void progress(int iteration, int agents_done, long comparisons, long removed)
+  {
+    __atomic_store_n(&current.iteration, iteration, __ATOMIC_RELAXED);
+    __atomic_store_n(&current.agents_done, agents_done, __ATOMIC_RELAXED);
+    __atomic_store_n(&current.comparisons, comparisons, __ATOMIC_RELAXED);
+    __atomic_store_n(&current.removed, removed, __ATOMIC_RELAXED);
+  }
+
+  static void publish(const Stats &stats);
+  // stores the latest statistics of the network; never blocks
+
+private:
+  struct Progress
+  {
+    int iteration;
+    int agents_done;
+    long comparisons;
+    long removed;
+  };
+
+  static void* server(void*);
+  static void snapshot(int client);
+
+  static bool enabled;
+  static Progress current;
+};
+
+// the monitor is a policy of the simulation's inner loop, like the tracers;
+// this one is used when there is no monitor, and costs nothing:
+struct NoMonitor
+{
+  static void progress(int, int, long, long) {}
+};
+
+#endif
+// MONITOR_H
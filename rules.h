@@ -0,0 +1,170 @@
+/*
+rules.h: the social comparison rules, as compile-time policies
+
+A rule adjusts the attribute of an agent (and possibly of its peer) when
+the agent compares itself to that peer. Rules are passed to the simulation
+as template arguments, so that each rule gets its own fully inlined sweep.
+*/
+
+#ifndef RULES_H
+#define RULES_H
+
+#include "main.h"
+#include "agent.h"
+#include "trace.h"
+
+enum RuleType
+{
+  RULE_CONTRAST = 0,  // the original assimilation/contrast rule
+  RULE_DEFFUANT = 1,  // bounded confidence (Deffuant et al., 2000)
+  RULE_CONTINUOUS = 2 // assimilation/contrast in steps relative to the difference
+};
+
+
+
+// clamping policies; they keep attributes within their range:
+
+struct Clamp
+{
+  static double apply(double attribute)
+  {
+    if (attribute > 1) return 1;
+    if (attribute < 0) return 0;
+    return attribute;
+  }
+};
+
+struct NoClamp
+{
+  static double apply(double attribute) { return attribute; }
+};
+
+
+
+// comparison rules:
+
+template <class Clamping = Clamp>
+struct ContrastRule
+// assimilate with a fixed step if the difference exceeds the treshold,
+// contrast with a fixed step if the difference is below it
+{
+  double treshold;
+  double step;
+
+  ContrastRule(double treshold, double step) : treshold(treshold), step(step) {}
+
+  void operator()(Agent* agent, Agent* peer) const
+  {
+    double attribute = agent->getattr();
+    double difference = attribute - peer->getattr();
+
+    // if the difference is exactly at the treshold, or if both
+    // attributes are equal, nothing happens:
+    if (abs(difference) > treshold) // assimilate!
+    {
+      if (difference < 0) attribute += step;
+      else if (difference > 0) attribute -= step;
+    }
+    else if (abs(difference) < treshold) // contrast!
+    {
+      if (difference < 0) attribute -= step;
+      else if (difference > 0) attribute += step;
+    }
+    agent->setattr(Clamping::apply(attribute));
+  }
+};
+
+template <class Clamping = NoClamp>
+struct DeffuantRule
+// both agents move towards each other if their difference is below the
+// treshold; the step is the fraction of the difference that they move
+{
+  double treshold;
+  double step;
+
+  DeffuantRule(double treshold, double step) : treshold(treshold), step(step) {}
+
+  void operator()(Agent* agent, Agent* peer) const
+  {
+    double difference = peer->getattr() - agent->getattr();
+    if (abs(difference) < treshold)
+    {
+      agent->setattr(Clamping::apply(agent->getattr() + step * difference));
+      peer->setattr(Clamping::apply(peer->getattr() - step * difference));
+    }
+  }
+};
+
+template <class Clamping = Clamp>
+struct ContinuousRule
+// like the contrast rule, but the agent moves a fraction of the
+// difference instead of a fixed step
+{
+  double treshold;
+  double step;
+
+  ContinuousRule(double treshold, double step) : treshold(treshold), step(step) {}
+
+  void operator()(Agent* agent, Agent* peer) const
+  {
+    double difference = peer->getattr() - agent->getattr();
+    if (abs(difference) > treshold) // assimilate!
+    {
+      agent->setattr(Clamping::apply(agent->getattr() + step * difference));
+    }
+    else if (abs(difference) < treshold) // contrast!
+    {
+      agent->setattr(Clamping::apply(agent->getattr() - step * difference));
+    }
+  }
+};
+
+
+
+// tracing policies; they are told about every event in the simulation:
+
+struct NoTrace
+{
+  static void compare(int, Agent*, Agent*, double) {}
+  static void remove(int, Agent*, Agent*) {}
+  static void add(int, Agent*, Agent*) {}
+};
+
+struct BinaryTrace
+// records the events in the binary event trace
+{
+  static void compare(int iteration, Agent* agent, Agent* peer, double old_attribute)
+  {
+    Trace::record(iteration, agent->getid(), peer->getid(), TRACE_COMPARE, old_attribute, agent->getattr());
+  }
+  static void remove(int iteration, Agent* agent, Agent* peer)
+  {
+    Trace::record(iteration, agent->getid(), peer->getid(), TRACE_REMOVE, agent->getattr(), peer->getattr());
+  }
+  static void add(int iteration, Agent* agent, Agent* peer)
+  {
+    Trace::record(iteration, agent->getid(), peer->getid(), TRACE_ADD, agent->getattr(), peer->getattr());
+  }
+};
+
+struct DebugTrace
+// prints the events to STDERR; used when DEBUG is true
+{
+  static void compare(int, Agent* agent, Agent* peer, double old_attribute)
+  {
+    cerr << "Agent " << agent->getid() << " (" << old_attribute << ") compares itself to agent "
+         << peer->getid() << " (" << peer->getattr() << "), attribute is now " << agent->getattr() << endl;
+  }
+  static void remove(int, Agent* agent, Agent* peer)
+  {
+    cerr << "Link treshold exceeded. Removing the link between agents " << agent->getid()
+         << " and " << peer->getid() << "...\n";
+  }
+  static void add(int, Agent* agent, Agent* peer)
+  {
+    cerr << "Linking agent " << agent->getid() << " to agent " << peer->getid() << "...\n";
+  }
+};
+
+#endif
+// RULES_H
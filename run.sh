@@ -4,6 +4,7 @@
 # and redirects the output streams (stdout and stderr) to files.
 
 # WARNING: Running this script will produce lots of files!
+# (`unet -B workers 1000 5000` runs the same grid without creating any files)
 
 i=1
 
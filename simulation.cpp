@@ -0,0 +1,291 @@
+/*
+simulation.cpp: the implementation of the Simulation class
+*/
+
+#include "main.h"
+#include "agent.h"
+#include "link.h"
+#include "attrindex.h"
+#include "simulation.h"
+#include "monitor.h"
+#include "memory.h"
+
+Simulation::Simulation(const Parameters &parameters)
+// constructor; creates the agents and a random network between them
+// according to the Erdős-Rényi (1959) model
+: parameters(parameters),
+  max_links((parameters.population_size * (parameters.population_size-1)) / 2),
+  iteration(0),
+  removed(0),
+  comparisons(0),
+  index(NULL),
+  position(parameters.population_size)
+{
+  Memory::Scope scope(MEMORY_GRAPH);
+
+  // reserve heap memory for the agent objects
+  Agent::resetIds();
+  population = new Agent[parameters.population_size];
+
+  Agent* random_agent1;
+  Agent* random_agent2;
+
+  // create some random links between agents:
+  for (int i=0; i<parameters.nr_of_links; i++)
+  {
+    do
+    { // assign both pointers the address of a random agent:
+      random_agent1 = &population[ gsl_rng_uniform_int(r,parameters.population_size) ];
+      random_agent2 = &population[ gsl_rng_uniform_int(r,parameters.population_size) ];
+    }
+    // retry if both agents are the same or if they are already linked:
+    while ( !validLink(random_agent1, random_agent2, relation) );
+
+    // add the link object to the linklist:
+    relation.push_back(Link(random_agent1,random_agent2));
+    // NOTE: in the above, the call to the Link constructor returns a value of the class type.
+    // When this happens, the copy constructor is invoked, which updates both agents' link
+    // lists so that they point to the address of the new (copied) link object.
+  }
+
+  // sort the agents by attribute, so that similar agents can be found quickly
+  if (parameters.homophily)
+  {
+    index = new AttributeIndex(parameters.population_size, population, parameters.link_treshold);
+  }
+
+  // in the first sweep, all agents are active
+  active.assign(parameters.population_size, true);
+  for (int i=0; i<parameters.population_size; i++) pending.push_back(i);
+}
+
+
+
+Simulation::~Simulation()
+// destructor; the links have to go before the agents they point to
+{
+  relation.clear();
+  delete index;
+  delete[] population;
+}
+
+
+
+void Simulation::iterate()
+// lets every active agent compare itself to all of its peers once
+{
+  Memory::Scope scope(MEMORY_GRAPH);
+
+  // pick the instantiation for the tracer and the progress monitor:
+  bool monitored = Monitor::isOpen();
+  if (DEBUG)
+  {
+    if (monitored) iterateWith<DebugTrace, Monitor>();
+    else iterateWith<DebugTrace, NoMonitor>();
+  }
+  else if (Trace::isOpen())
+  {
+    if (monitored) iterateWith<BinaryTrace, Monitor>();
+    else iterateWith<BinaryTrace, NoMonitor>();
+  }
+  else
+  {
+    if (monitored) iterateWith<NoTrace, Monitor>();
+    else iterateWith<NoTrace, NoMonitor>();
+  }
+  iteration++;
+}
+
+
+
+Stats Simulation::getStats(bool with_avgpath)
+// returns the statistics of the network in its current state
+{
+  Memory::Scope scope(MEMORY_SCRATCH);
+  Stats stats;
+  stats.iterations = iteration;
+  stats.removed = removed;
+  stats.links = relation.size();
+  stats.density = relation.size() / static_cast<double>(max_links);
+  stats.clustering = clustering(parameters.population_size, population, relation);
+  stats.assortativity = assortativity(relation);
+  stats.avgpath = with_avgpath ? avgpath(parameters.population_size, population) : 0;
+  return stats;
+}
+
+
+
+Stats simulate(const Parameters &parameters, unsigned long seed, bool with_avgpath)
+// runs a complete simulation and returns the final statistics
+{
+  gsl_rng_set(r, seed);
+  Simulation simulation(parameters);
+  while (simulation.getIteration() <= MAXIMUM_ITERATIONS && !simulation.isQuiescent()) simulation.iterate();
+  return simulation.getStats(with_avgpath);
+}
+
+
+
+void Simulation::activate(Agent* agent)
+// makes an agent compare itself to its peers in this sweep if it is still
+// to come, or else in the next sweep
+{
+  int i = agent - population;
+  if (active[i]) return;
+  active[i] = true;
+  if (i > position) queue.push(i);
+  else pending.push_back(i);
+}
+
+
+
+void Simulation::activateNeighbourhood(Agent* agent)
+// activates an agent whose attribute changed, and all of its peers
+{
+  activate(agent);
+  list<Link*> &links = agent->getLinks();
+  for (list<Link*>::iterator it=links.begin(); it!=links.end(); it++)
+  {
+    activate((*it)->getOther(agent));
+  }
+}
+
+
+
+template <class Tracer, class Progress>
+void Simulation::iterateWith()
+// picks the instantiation of the sweep for the comparison rule
+{
+  double treshold = parameters.assimilation_treshold;
+  double step = parameters.assimilation_step;
+
+  switch (parameters.rule)
+  {
+    case RULE_CONTRAST:
+      sweep<ContrastRule<>, Tracer, Progress>(ContrastRule<>(treshold, step));
+      break;
+    case RULE_DEFFUANT:
+      sweep<DeffuantRule<>, Tracer, Progress>(DeffuantRule<>(treshold, step));
+      break;
+    case RULE_CONTINUOUS:
+      sweep<ContinuousRule<>, Tracer, Progress>(ContinuousRule<>(treshold, step));
+      break;
+  }
+}
+
+
+
+template <class Rule, class Tracer, class Progress>
+void Simulation::sweep(const Rule &rule)
+// the inner loop of the simulation, instantiated for each rule, tracer and monitor
+{
+  // the events lead up to the next row of the progress table
+  int row = iteration + 1;
+
+  // loop over the active agents, in the same order as over all agents:
+  queue = priority_queue<int, vector<int>, greater<int> >(pending.begin(), pending.end());
+  pending.clear();
+  while (!queue.empty())
+  {
+    int j = queue.top();
+    queue.pop();
+    position = j;
+    active[j] = false;
+
+    // loop over all its links; over a copy, since the comparisons may remove them
+    // (each link is only removed after its own comparison, so the copy stays valid)
+    list<Link*> links;
+    {
+      Memory::Scope scope(MEMORY_SCRATCH);
+      links = population[j].getLinks();
+    }
+    list<Link*>::iterator it;
+    for (it=links.begin(); it!=links.end(); it++)
+    {
+      Agent* agent = &population[j];
+      Agent* peer = (*it)->getOther(agent);
+
+      // weak links are less likely to lead to a social comparison:
+      // (and the agent has to try again in the next sweep)
+      if (parameters.weighted_frequency && gsl_rng_uniform(r) >= (*it)->getWeight())
+      {
+        activate(agent);
+        continue;
+      }
+
+      // the agent makes a social comparison with this peer and adjusts its attribute:
+      double attribute = agent->getattr();
+      double peer_attribute = peer->getattr();
+      rule(agent, peer);
+      comparisons++;
+      Tracer::compare(row, agent, peer, attribute);
+
+      // some rules (Deffuant) move the peer as well; record that the same way
+      if (peer->getattr() != peer_attribute) Tracer::compare(row, peer, agent, peer_attribute);
+
+      // a changed attribute may change the outcome of other comparisons:
+      if (agent->getattr() != attribute)
+      {
+        if (index) index->update(agent);
+        activateNeighbourhood(agent);
+      }
+      if (peer->getattr() != peer_attribute)
+      {
+        if (index) index->update(peer);
+        activateNeighbourhood(peer);
+      }
+
+      // calculate the attribute difference after this adjustment...
+      double difference = abs(agent->getattr() - peer->getattr());
+
+      // ... and replace it with a random link if it exceeds the link treshold
+      if (difference > parameters.link_treshold)
+      {
+        Tracer::remove(row, agent, peer);
+        activate(agent);
+        activate(peer);
+        removeLink(agent, peer, relation);
+        removed++;
+
+        // REMOVE THE FOLLOWING TO PREVENT AUTOMATIC NEW LINKS
+        rewire<Tracer>();
+      }
+    }
+
+    Progress::progress(row, j + 1, comparisons, removed);
+  }
+
+  // everything that is activated from now on is for the next sweep
+  position = parameters.population_size;
+}
+
+
+
+template <class Tracer>
+void Simulation::rewire()
+// adds a new link to replace a removed one
+{
+  if (index)
+  { // link two agents with similar attributes:
+    addSimilarLink(parameters.population_size, population, *index, relation);
+  }
+  else
+  {
+    Agent* random_agent1;
+    Agent* random_agent2;
+    do
+    { // assign both pointers the address of a random agent:
+      random_agent1 = &population[ gsl_rng_uniform_int(r,parameters.population_size) ];
+      random_agent2 = &population[ gsl_rng_uniform_int(r,parameters.population_size) ];
+    }
+    // retry if both agents are the same or if they are already linked:
+    while ( !validLink(random_agent1, random_agent2, relation) );
+
+    // add the link object to the linklist:
+    relation.push_back(Link(random_agent1,random_agent2));
+  }
+
+  Tracer::add(iteration + 1, relation.back().getSource(), relation.back().getTarget());
+  activate(relation.back().getSource());
+  activate(relation.back().getTarget());
+}
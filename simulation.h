@@ -0,0 +1,94 @@
+/*
+simulation.h: interface of the Simulation class
+*/
+
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "main.h"
+#include "rules.h"
+
+#include <queue>
+#include <functional>
+
+struct Parameters
+{
+  int population_size;
+  int nr_of_links;
+  double assimilation_treshold;
+  double assimilation_step;
+  double link_treshold;
+  RuleType rule; // the social comparison rule
+  bool homophily; // replace removed links with links between similar agents
+  bool weighted_frequency; // compare with a probability equal to the link weight
+};
+
+struct Stats
+{
+  int iterations;
+  int removed; // the nr. of removed links
+  int links; // the nr. of links
+  double density;
+  double clustering;
+  double assortativity;
+  double avgpath; // only calculated on request, since it takes long
+};
+
+class Simulation
+{
+public:
+
+  // constructor; creates the agents and a random network between them
+  Simulation(const Parameters &parameters);
+  ~Simulation();
+
+  void iterate();
+  // lets every active agent compare itself to all of its peers once
+
+  bool isQuiescent() { return pending.empty(); }
+  // returns true if no agent is active, i.e. the network will never change again
+
+  Stats getStats(bool with_avgpath);
+  // returns the statistics of the network in its current state
+
+  // the following are trivial, so implemented here:
+  int getIteration() { return iteration; }
+  int getRemoved() { return removed; }
+  int getMaxLinks() { return max_links; }
+  Agent* getPopulation() { return population; }
+  list<Link>& getRelation() { return relation; }
+
+private:
+  template <class Tracer, class Progress> void iterateWith();
+  template <class Rule, class Tracer, class Progress> void sweep(const Rule &rule);
+  template <class Tracer> void rewire();
+  void activate(Agent* agent);
+  void activateNeighbourhood(Agent* agent);
+
+  Parameters parameters;
+  int max_links;
+  int iteration; // the nr. of completed sweeps
+  int removed; // the nr. of removed links
+  long comparisons; // the nr. of social comparisons
+  Agent* population;
+  list<Link> relation;
+  AttributeIndex* index; // only used for homophilous rewiring
+
+  // An agent is active if its attribute, a peer's attribute or its links
+  // changed since it last compared itself to its peers; if none did, all of
+  // its comparisons would come to nothing again, so it can be skipped.
+  vector<bool> active;
+  priority_queue<int, vector<int>, greater<int> > queue; // the active agents still to come in this sweep
+  vector<int> pending; // the active agents for the next sweep
+  int position; // the agent that is comparing itself now
+
+  // the simulation can't be copied, since the links point to its agents
+  Simulation(const Simulation&);
+  Simulation& operator=(const Simulation&);
+};
+
+Stats simulate(const Parameters &parameters, unsigned long seed, bool with_avgpath);
+// runs a complete simulation and returns the final statistics
+
+#endif
+// SIMULATION_H
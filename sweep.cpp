@@ -0,0 +1,358 @@
+/*
+sweep.cpp: an adaptive sweep over the parameter space
+*/
+
+#include "main.h"
+#include "sweep.h"
+#include "batch.h"
+
+#include <map>
+#include <set>
+#include <algorithm>
+
+#define NR_OF_STATS 3 // density, clustering and assortativity
+
+struct SweepPoint
+// the accumulated statistics of all runs of one point of the grid
+{
+  int runs;
+  double sum[NR_OF_STATS];
+  double sum_2[NR_OF_STATS];
+
+  SweepPoint() : runs(0)
+  {
+    for (int s=0; s<NR_OF_STATS; s++) sum[s] = sum_2[s] = 0;
+  }
+
+  void add(const Stats &stats)
+  {
+    double values[NR_OF_STATS] = { stats.density, stats.clustering, stats.assortativity };
+    for (int s=0; s<NR_OF_STATS; s++)
+    {
+      sum[s] += values[s];
+      sum_2[s] += values[s] * values[s];
+    }
+    runs++;
+  }
+
+  double mean(int s) const { return sum[s] / runs; }
+
+  double deviation(int s) const
+  // the sample standard deviation, or 0 if there is only one run
+  {
+    if (runs < 2) return 0;
+    double variance = (sum_2[s] - sum[s] * sum[s] / runs) / (runs - 1);
+    return variance > 0 ? sqrt(variance) : 0;
+  }
+
+  double error(int s) const { return deviation(s) / sqrt(static_cast<double>(runs)); }
+};
+
+struct SweepCell
+// a cube of the grid, given by its lowest corner and the length of its sides
+{
+  int x, y, z;
+  int size;
+};
+
+class AdaptiveSweep
+{
+public:
+  AdaptiveSweep(const Parameters &parameters, int nr_of_workers, unsigned long seed, bool verbose);
+  void run();
+  void print();
+
+private:
+  int key(int x, int y, int z) { return (x * (SWEEP_UNITS+1) + y) * (SWEEP_UNITS+1) + z; }
+  int corner(const SweepCell &cell, int c);
+  double sharpness(const SweepCell &cell);
+  bool needsReplicates(const SweepPoint &point);
+  void addRuns(const vector<int> &keys);
+
+  Parameters parameters;
+  int nr_of_workers;
+  unsigned long seed;
+  bool verbose;
+  int runs; // the total nr. of runs so far
+  double tolerance[NR_OF_STATS]; // the change in each statistic that counts as sharp
+  map<int, SweepPoint> points;
+  vector<SweepCell> cells;
+};
+
+
+
+void adaptiveSweep(Parameters parameters, int nr_of_workers, unsigned long seed, bool verbose)
+// sweeps the parameter space and prints the statistics of every point to STDOUT
+{
+  AdaptiveSweep sweep(parameters, nr_of_workers, seed, verbose);
+  sweep.run();
+  sweep.print();
+}
+
+
+
+/*****************************************************************************/
+
+
+
+static double value(int unit)
+// returns the parameter value of a position on the finest grid
+{
+  return SWEEP_MIN + unit * (SWEEP_MAX - SWEEP_MIN) / SWEEP_UNITS;
+}
+
+
+
+AdaptiveSweep::AdaptiveSweep(const Parameters &parameters, int nr_of_workers, unsigned long seed, bool verbose)
+: parameters(parameters),
+  nr_of_workers(nr_of_workers),
+  seed(seed),
+  verbose(verbose),
+  runs(0)
+{
+  for (int s=0; s<NR_OF_STATS; s++) tolerance[s] = 0;
+}
+
+
+
+int AdaptiveSweep::corner(const SweepCell &cell, int c)
+// returns the key of one of the eight corners (0-7) of a cell
+{
+  return key(cell.x + ((c & 1) ? cell.size : 0),
+             cell.y + ((c & 2) ? cell.size : 0),
+             cell.z + ((c & 4) ? cell.size : 0));
+}
+
+
+
+double AdaptiveSweep::sharpness(const SweepCell &cell)
+// returns how many times the tolerance the largest change along the edges of
+// a cell is, or 0 if no statistic changes by more than the tolerance plus noise
+{
+  double result = 0;
+  for (int c=0; c<8; c++)
+  {
+    SweepPoint &point = points[corner(cell, c)];
+
+    // compare each corner to its neighbours along the x, y and z edges
+    for (int axis=1; axis<8; axis*=2)
+    {
+      if (c & axis) continue;
+      SweepPoint &neighbour = points[corner(cell, c | axis)];
+      if (!point.runs || !neighbour.runs) continue; // a point that failed
+
+      for (int s=0; s<NR_OF_STATS; s++)
+      {
+        if (tolerance[s] == 0) continue;
+        double change = abs(point.mean(s) - neighbour.mean(s));
+        double noise = 2 * sqrt(pow(point.error(s),2) + pow(neighbour.error(s),2));
+        if (change - noise > tolerance[s]) result = max(result, change / tolerance[s]);
+      }
+    }
+  }
+  return result;
+}
+
+
+
+bool AdaptiveSweep::needsReplicates(const SweepPoint &point)
+// returns true if a point has too few runs to trust its means
+{
+  if (point.runs < SWEEP_MIN_REPLICATES) return true;
+  if (point.runs >= SWEEP_MAX_REPLICATES) return false;
+  for (int s=0; s<NR_OF_STATS; s++)
+  {
+    if (point.error(s) > tolerance[s] / 2) return true;
+  }
+  return false;
+}
+
+
+
+void AdaptiveSweep::addRuns(const vector<int> &keys)
+// runs one more replicate of each of the points, as far as the budget allows
+{
+  vector<Parameters> batch;
+  vector<unsigned long> seeds;
+  vector<Stats> results;
+  vector<bool> failed;
+
+  for (unsigned int i=0; i<keys.size() && runs + i < SWEEP_BUDGET; i++)
+  {
+    Parameters point = parameters;
+    point.assimilation_treshold = value(keys[i] / ((SWEEP_UNITS+1) * (SWEEP_UNITS+1)));
+    point.assimilation_step = value((keys[i] / (SWEEP_UNITS+1)) % (SWEEP_UNITS+1));
+    point.link_treshold = value(keys[i] % (SWEEP_UNITS+1));
+    batch.push_back(point);
+    seeds.push_back(seed + runs + i);
+  }
+
+  if (nr_of_workers > 0)
+  {
+    runBatch(batch, seeds, nr_of_workers, false, results, failed);
+  }
+  else
+  {
+    // run them one after the other in this process
+    results.resize(batch.size());
+    failed.assign(batch.size(), false);
+    for (unsigned int i=0; i<batch.size(); i++) results[i] = simulate(batch[i], seeds[i], false);
+  }
+
+  // a failed run still counts against the budget
+  for (unsigned int i=0; i<results.size(); i++)
+  {
+    if (!failed[i]) points[keys[i]].add(results[i]);
+  }
+  runs += results.size();
+}
+
+
+
+void AdaptiveSweep::run()
+// starts with the coarse grid and keeps subdividing the sharpest cells
+{
+  // the coarse grid:
+  vector<int> keys;
+  for (int x=0; x<=SWEEP_UNITS; x+=SWEEP_COARSE)
+    for (int y=0; y<=SWEEP_UNITS; y+=SWEEP_COARSE)
+      for (int z=0; z<=SWEEP_UNITS; z+=SWEEP_COARSE)
+      {
+        keys.push_back(key(x,y,z));
+        if (x < SWEEP_UNITS && y < SWEEP_UNITS && z < SWEEP_UNITS)
+        {
+          SweepCell cell = { x, y, z, SWEEP_COARSE };
+          cells.push_back(cell);
+        }
+      }
+
+  if (verbose) cerr << "Running the coarse grid of " << keys.size() << " points...\n";
+  addRuns(keys);
+
+  // a sharp change is a fraction of the range of each statistic on the coarse grid
+  for (int s=0; s<NR_OF_STATS; s++)
+  {
+    double low = 0;
+    double high = 0;
+    bool first = true;
+    for (unsigned int i=0; i<keys.size(); i++)
+    {
+      SweepPoint &point = points[keys[i]];
+      if (!point.runs) continue;
+      low = first ? point.mean(s) : min(low, point.mean(s));
+      high = first ? point.mean(s) : max(high, point.mean(s));
+      first = false;
+    }
+    tolerance[s] = SWEEP_TOLERANCE * (high - low);
+  }
+
+  cerr << "#Round    Runs     Cells    Sharp    Points\n";
+  int round = 0;
+  while (runs < SWEEP_BUDGET)
+  {
+    // find the cells that can still be subdivided, sharpest first
+    vector< pair<double,int> > sharp;
+    for (unsigned int i=0; i<cells.size(); i++)
+    {
+      if (cells[i].size < 2) continue;
+      double score = sharpness(cells[i]);
+      if (score > 0) sharp.push_back(make_pair(-score, i));
+    }
+    sort(sharp.begin(), sharp.end());
+
+    fprintf (stderr, "%-10d", round++);
+    fprintf (stderr, "%-9d", runs);
+    fprintf (stderr, "%-9d", static_cast<int>(cells.size()));
+    fprintf (stderr, "%-9d", static_cast<int>(sharp.size()));
+    fprintf (stderr, "%-9d", static_cast<int>(points.size()));
+    cerr << endl;
+
+    if (sharp.empty()) break;
+
+    // first make sure that the changes in the cells to subdivide aren't just noise
+    vector<int> replicates;
+    set<int> seen;
+    for (unsigned int i=0; i<sharp.size() && i<SWEEP_SPLITS; i++)
+    {
+      for (int c=0; c<8; c++)
+      {
+        int k = corner(cells[sharp[i].second], c);
+        if (needsReplicates(points[k]) && seen.insert(k).second) replicates.push_back(k);
+      }
+    }
+    if (!replicates.empty())
+    {
+      addRuns(replicates);
+      continue;
+    }
+
+    // then subdivide the sharpest cells into eight cells each, for as long as
+    // the new points fit within the budget; the next round will tell which
+    // of the parts still contain the sharp change
+    vector<int> new_points;
+    seen.clear();
+    int subdivided = 0;
+    for (unsigned int i=0; i<sharp.size() && subdivided < SWEEP_SPLITS; i++)
+    {
+      SweepCell cell = cells[sharp[i].second];
+      int half = cell.size / 2;
+
+      vector<int> cell_points;
+      for (int dx=0; dx<=2; dx++)
+        for (int dy=0; dy<=2; dy++)
+          for (int dz=0; dz<=2; dz++)
+          {
+            int k = key(cell.x + dx*half, cell.y + dy*half, cell.z + dz*half);
+            if (points.find(k) == points.end() && seen.find(k) == seen.end()) cell_points.push_back(k);
+          }
+      if (runs + new_points.size() + cell_points.size() > SWEEP_BUDGET) break;
+
+      for (unsigned int p=0; p<cell_points.size(); p++)
+      {
+        seen.insert(cell_points[p]);
+        new_points.push_back(cell_points[p]);
+      }
+
+      // the cell itself becomes the first of its eight parts
+      cells[sharp[i].second].size = half;
+      for (int c=1; c<8; c++)
+      {
+        SweepCell part = { cell.x + ((c & 1) ? half : 0),
+                           cell.y + ((c & 2) ? half : 0),
+                           cell.z + ((c & 4) ? half : 0), half };
+        cells.push_back(part);
+      }
+      subdivided++;
+    }
+    if (!subdivided) break;
+
+    addRuns(new_points);
+  }
+
+  if (verbose) cerr << "Sweep finished after " << runs << " runs of at most " << SWEEP_BUDGET << endl;
+}
+
+
+
+void AdaptiveSweep::print()
+// prints the mean statistics of all points of the grid
+{
+  cout << "pop_size nr_links ass_tres ass_step lnk_tres runs     density  clustrng assrtvty sd_clust sd_assrt\n";
+  for (map<int, SweepPoint>::iterator it=points.begin(); it!=points.end(); it++)
+  {
+    SweepPoint &point = it->second;
+    if (!point.runs) continue;
+    printf ("%-9d", parameters.population_size);
+    printf ("%-9d", parameters.nr_of_links);
+    printf ("%-9.4f", value(it->first / ((SWEEP_UNITS+1) * (SWEEP_UNITS+1))));
+    printf ("%-9.4f", value((it->first / (SWEEP_UNITS+1)) % (SWEEP_UNITS+1)));
+    printf ("%-9.4f", value(it->first % (SWEEP_UNITS+1)));
+    printf ("%-9d", point.runs);
+    printf ("%-9.2f", point.mean(0));
+    printf ("%-9.2f", point.mean(1));
+    printf ("%-9.2f", point.mean(2));
+    printf ("%-9.2f", point.deviation(1));
+    printf ("%-9.2f", point.deviation(2));
+    cout << endl;
+  }
+}
@@ -0,0 +1,33 @@
+/*
+sweep.h: an adaptive sweep over the parameter space
+
+Instead of the fixed grid of run.sh, the sweep starts with a coarse grid
+over the assimilation treshold, the assimilation step and the link treshold,
+and only subdivides the cells of the grid in which the density, clustering
+or assortativity change sharply between neighbouring points. Points in such
+cells get replicate runs until the change stands out from the noise.
+*/
+
+#ifndef SWEEP_H
+#define SWEEP_H
+
+#include "main.h"
+#include "simulation.h"
+
+#define SWEEP_MIN 0.05          // lowest value of all three parameters
+#define SWEEP_MAX 0.45          // highest value of all three parameters
+#define SWEEP_UNITS 32          // nr. of steps of the finest grid between the two
+#define SWEEP_COARSE 8          // nr. of finest steps between the points of the coarse grid
+#define SWEEP_TOLERANCE 0.2     // a sharp change is this fraction of the range of a statistic
+#define SWEEP_MIN_REPLICATES 2  // nr. of runs before a point can take part in a subdivision
+#define SWEEP_MAX_REPLICATES 5  // nr. of runs after which a point is never rerun
+#define SWEEP_SPLITS 8          // the maximum nr. of cells subdivided in one round
+#define SWEEP_BUDGET 729        // the maximum nr. of runs (as many as run.sh does)
+
+void adaptiveSweep(Parameters parameters, int nr_of_workers, unsigned long seed, bool verbose);
+// sweeps the parameter space and prints the statistics of every point to STDOUT;
+// the population size, nr. of links, rule and options are taken from the parameters,
+// and the runs of each round are spread over nr_of_workers processes if there are any
+
+#endif
+// SWEEP_H
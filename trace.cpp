@@ -0,0 +1,138 @@
+/*
+trace.cpp: the implementation of the binary event trace
+*/
+
+#include "main.h"
+#include "trace.h"
+#include "memory.h"
+
+#include <cstdio>
+#include <pthread.h>
+
+bool Trace::enabled = false;
+__thread TraceBuffer* Trace::buffer = NULL;
+
+static FILE* file = NULL;
+static pthread_t thread;
+static pthread_mutex_t buffers_lock = PTHREAD_MUTEX_INITIALIZER;
+static TraceBuffer* buffers = NULL; // the ring buffers of all threads
+static bool stopping = false;
+
+
+
+bool Trace::open(const char* filename)
+// opens the trace file and starts the background writer thread
+{
+  file = fopen(filename, "wb");
+  if (!file)
+  {
+    cerr << "error: Could not open trace file " << filename << endl;
+    return false;
+  }
+  setvbuf(file, NULL, _IOFBF, 1 << 20);
+  fwrite(TRACE_MAGIC, 1, 8, file);
+
+  stopping = false;
+  if (pthread_create(&thread, NULL, writer, NULL) != 0)
+  {
+    cerr << "error: Could not start the trace writer thread\n";
+    fclose(file);
+    return false;
+  }
+  enabled = true;
+  return true;
+}
+
+
+
+void Trace::close()
+// writes the remaining events and closes the trace file
+{
+  if (!enabled) return;
+  enabled = false;
+
+  // let the writer thread empty all buffers before it stops
+  __atomic_store_n(&stopping, true, __ATOMIC_RELEASE);
+  pthread_join(thread, NULL);
+  fclose(file);
+
+  while (buffers)
+  {
+    TraceBuffer* next = buffers->next;
+    delete buffers;
+    buffers = next;
+  }
+  buffer = NULL;
+}
+
+
+
+TraceBuffer* Trace::addBuffer()
+// creates the ring buffer of the calling thread; only done once per thread
+{
+  Memory::Scope scope(MEMORY_OUTPUT);
+  TraceBuffer* b = new TraceBuffer;
+  b->head = 0;
+  b->tail = 0;
+
+  pthread_mutex_lock(&buffers_lock);
+  b->next = buffers;
+  __atomic_store_n(&buffers, b, __ATOMIC_RELEASE);
+  pthread_mutex_unlock(&buffers_lock);
+
+  return b;
+}
+
+
+
+void Trace::wait()
+// gives the writer thread some time to empty a full buffer
+{
+  usleep(100);
+}
+
+
+
+static unsigned int drain(TraceBuffer* b)
+// writes all events in a ring buffer to the file, returns the nr. of events
+{
+  unsigned int head = __atomic_load_n(&b->head, __ATOMIC_ACQUIRE);
+  unsigned int tail = b->tail;
+  unsigned int written = head - tail;
+
+  while (tail != head)
+  {
+    // write the events up to the head or up to the end of the array
+    unsigned int start = tail % TRACE_BUFFER_SIZE;
+    unsigned int count = head - tail;
+    if (count > TRACE_BUFFER_SIZE - start) count = TRACE_BUFFER_SIZE - start;
+
+    fwrite(&b->events[start], sizeof(TraceEvent), count, file);
+    tail += count;
+    __atomic_store_n(&b->tail, tail, __ATOMIC_RELEASE);
+  }
+  return written;
+}
+
+
+
+void* Trace::writer(void*)
+// the background thread that keeps emptying the ring buffers
+{
+  while (true)
+  {
+    // NOTE: read the flag before draining, so the last pass gets everything
+    bool stop = __atomic_load_n(&stopping, __ATOMIC_ACQUIRE);
+
+    unsigned int written = 0;
+    TraceBuffer* b = __atomic_load_n(&buffers, __ATOMIC_ACQUIRE);
+    for (; b; b=b->next) written += drain(b);
+
+    if (!written)
+    {
+      if (stop) break;
+      usleep(1000);
+    }
+  }
+  return NULL;
+}
@@ -0,0 +1,85 @@
+/*
+trace.h: interface of the binary event trace
+
+The trace file starts with the 8 characters "UNETTRC1", followed by a
+stream of fixed-size TraceEvent records in the byte order of the machine.
+Use the tracedump program to convert a trace file to text.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+#define TRACE_MAGIC "UNETTRC1"
+#define TRACE_BUFFER_SIZE 65536 // nr. of events in each thread's ring buffer
+
+enum TraceAction
+{
+  TRACE_COMPARE = 0, // the agent compared itself to the peer (or was moved by it)
+  TRACE_REMOVE = 1,  // the link between the agent and the peer was removed
+  TRACE_ADD = 2      // a link between the agent and the peer was added
+};
+
+struct TraceEvent
+{
+  int32_t iteration; // the row of the progress table that the event leads up to
+  int32_t agent;
+  int32_t peer;
+  int32_t action; // one of the TraceActions
+  double attribute1; // compare: the agent's old attribute, else: the agent's attribute
+  double attribute2; // compare: the agent's new attribute, else: the peer's attribute
+};
+
+struct TraceBuffer
+{
+  TraceEvent events[TRACE_BUFFER_SIZE];
+  unsigned int head; // the nr. of events written by the thread
+  unsigned int tail; // the nr. of events written to the file
+  TraceBuffer* next; // the buffer of the next thread
+};
+
+class Trace
+{
+public:
+
+  static bool open(const char* filename);
+  // opens the trace file and starts the background writer thread
+
+  static void close();
+  // writes the remaining events and closes the trace file
+
+  static bool isOpen() { return enabled; }
+
+  // adds an event to the ring buffer of the calling thread:
+  static void record(int iteration, int agent, int peer, TraceAction action,
+                     double attribute1, double attribute2)
+  {
+    if (!enabled) return;
+    if (!buffer) buffer = addBuffer();
+
+    // wait for the writer thread if the ring buffer is full
+    unsigned int head = buffer->head;
+    while (head - __atomic_load_n(&buffer->tail, __ATOMIC_ACQUIRE) == TRACE_BUFFER_SIZE) wait();
+
+    TraceEvent &event = buffer->events[head % TRACE_BUFFER_SIZE];
+    event.iteration = iteration;
+    event.agent = agent;
+    event.peer = peer;
+    event.action = action;
+    event.attribute1 = attribute1;
+    event.attribute2 = attribute2;
+    __atomic_store_n(&buffer->head, head + 1, __ATOMIC_RELEASE);
+  }
+
+private:
+  static TraceBuffer* addBuffer();
+  static void wait();
+  static void* writer(void*);
+
+  static bool enabled;
+  static __thread TraceBuffer* buffer; // the ring buffer of this thread
+};
+
+#endif
+// TRACE_H
@@ -0,0 +1,47 @@
+/*
+tracedump.cpp: prints a binary event trace of unet as text
+*/
+
+#include <cstdio>
+#include <cstring>
+#include "trace.h"
+
+int main(int argc, char *argv[])
+{
+  if (argc != 2)
+  {
+    fprintf(stderr, "\nUsage: %s tracefile\n\n", argv[0]);
+    return 1;
+  }
+
+  FILE* file = fopen(argv[1], "rb");
+  if (!file)
+  {
+    fprintf(stderr, "error: Could not open trace file %s\n", argv[1]);
+    return 1;
+  }
+
+  char magic[8];
+  if (fread(magic, 1, 8, file) != 8 || memcmp(magic, TRACE_MAGIC, 8) != 0)
+  {
+    fprintf(stderr, "error: %s is not a unet trace file\n", argv[1]);
+    return 1;
+  }
+
+  const char* actions[] = { "compare", "remove", "add" };
+
+  printf("#Iteration Action  Agent    Peer     Attr1    Attr2\n");
+  TraceEvent event;
+  while (fread(&event, sizeof(TraceEvent), 1, file) == 1)
+  {
+    printf("%-11d", event.iteration);
+    printf("%-8s", (event.action >= 0 && event.action <= 2) ? actions[event.action] : "?");
+    printf("%-9d", event.agent);
+    printf("%-9d", event.peer);
+    printf("%-9.4f", event.attribute1);
+    printf("%-9.4f\n", event.attribute2);
+  }
+
+  fclose(file);
+  return 0;
+}
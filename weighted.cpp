@@ -0,0 +1,256 @@
+/*
+weighted.cpp: statistics of the network that take the link weights into account
+*/
+
+#include "main.h"
+#include "agent.h"
+#include "link.h"
+#include "weighted.h"
+#include "memory.h"
+
+#include <algorithm>
+#include <pthread.h>
+
+// the job that is shared by all threads calculating path lengths:
+struct PathlengthJob
+{
+  WeightedGraph* graph;
+  int* next_source; // the next agent to calculate the path lengths for
+  double sum; // the sum of the path lengths found by this thread
+};
+
+WeightedGraph::WeightedGraph(int nr_of_agents, Agent population[])
+// constructor; copies the link lists into flat arrays, so that the
+// statistics below don't have to chase the pointers of the lists
+: nr_of_agents(nr_of_agents),
+  max_weight(0),
+  first(nr_of_agents + 1),
+  strength(nr_of_agents, 0)
+{
+  list<Link*>::iterator it;
+  for (int i=0; i<nr_of_agents; i++)
+  {
+    first[i] = peers.size();
+    list<Link*> &links = population[i].getLinks();
+    for (it=links.begin(); it!=links.end(); it++)
+    {
+      double weight = (*it)->getWeight();
+      peers.push_back((*it)->getOther(&population[i]) - population);
+      weights.push_back(weight);
+      strength[i] += weight;
+      if (weight > max_weight) max_weight = weight;
+    }
+  }
+  first[nr_of_agents] = peers.size();
+}
+
+
+
+double WeightedGraph::clusteringBarrat()
+// returns the average of all agents' local weighted clustering, where each
+// closed triangle counts with the mean weight of the agent's two links
+{
+  vector<double> marked(nr_of_agents, -1); // weight of the link to each peer
+  double sum = 0;
+
+  for (int i=0; i<nr_of_agents; i++)
+  {
+    int degree = first[i+1] - first[i];
+    if (degree < 2 || strength[i] == 0) continue;
+
+    // mark the personal network of the agent
+    for (int p=first[i]; p<first[i+1]; p++) marked[peers[p]] = weights[p];
+
+    // find the peers of its peers that are also in the personal network
+    // NOTE: this counts every triangle twice, once for each of the two peers
+    double triangles = 0;
+    for (int p=first[i]; p<first[i+1]; p++)
+    {
+      int j = peers[p];
+      for (int q=first[j]; q<first[j+1]; q++)
+      {
+        int h = peers[q];
+        if (h != i && marked[h] >= 0) triangles += (weights[p] + marked[h]) / 2;
+      }
+    }
+    sum += triangles / (strength[i] * (degree - 1));
+
+    for (int p=first[i]; p<first[i+1]; p++) marked[peers[p]] = -1;
+  }
+  return sum / nr_of_agents;
+}
+
+
+
+double WeightedGraph::clusteringOnnela()
+// returns the average of all agents' local weighted clustering, where each
+// closed triangle counts with the geometric mean of its three link weights
+{
+  vector<double> marked(nr_of_agents, -1); // weight of the link to each peer
+  double sum = 0;
+
+  if (max_weight == 0) return 0; // prevent zero-division
+
+  for (int i=0; i<nr_of_agents; i++)
+  {
+    int degree = first[i+1] - first[i];
+    if (degree < 2) continue;
+
+    for (int p=first[i]; p<first[i+1]; p++) marked[peers[p]] = weights[p];
+
+    double triangles = 0;
+    for (int p=first[i]; p<first[i+1]; p++)
+    {
+      int j = peers[p];
+      for (int q=first[j]; q<first[j+1]; q++)
+      {
+        int h = peers[q];
+        if (h != i && marked[h] >= 0)
+        {
+          triangles += cbrt(weights[p] * marked[h] * weights[q]) / max_weight;
+        }
+      }
+    }
+    sum += triangles / (degree * (degree - 1.0));
+
+    for (int p=first[i]; p<first[i+1]; p++) marked[peers[p]] = -1;
+  }
+  return sum / nr_of_agents;
+}
+
+
+
+double WeightedGraph::assortativity()
+// returns the Pearson correlation between the strengths at both ends of
+// each link, calculated the same way as the (unweighted) assortativity
+{
+  double n = 0;
+  double x, y;
+  double sum_x = 0;
+  double sum_y = 0;
+  double sum_x_y = 0;
+  double sum_x_2 = 0;
+  double sum_y_2 = 0;
+
+  // visit each link once, from the agent with the lowest id (the source)
+  for (int i=0; i<nr_of_agents; i++)
+  {
+    for (int p=first[i]; p<first[i+1]; p++)
+    {
+      if (peers[p] < i) continue;
+      x = strength[i];
+      y = strength[peers[p]];
+      n++;
+      sum_x += x;
+      sum_y += y;
+      sum_x_y += x * y;
+      sum_x_2 += x * x;
+      sum_y_2 += y * y;
+    }
+  }
+
+  if ( n*sum_x_2 == sum_x*sum_x || n*sum_y_2 == sum_y*sum_y )
+  {
+    if (DEBUG) cerr << "warning: No variance in strength of links\n";
+    return 0;
+  }
+
+  return (n * sum_x_y - sum_x * sum_y) /
+         sqrt( (n * sum_x_2 - sum_x*sum_x) * (n * sum_y_2 - sum_y*sum_y) );
+}
+
+
+
+double WeightedGraph::pathlengths(int source, vector<double> &distance, vector< pair<double,int> > &heap)
+// returns the sum of the shortest weighted path lengths from the source
+// to every agent it can reach (Dijkstra, with a heap of negated distances)
+{
+  double sum = 0;
+
+  fill(distance.begin(), distance.end(), -1);
+  heap.clear();
+  heap.push_back(make_pair(-0.0, source));
+
+  while (!heap.empty())
+  {
+    pop_heap(heap.begin(), heap.end());
+    double steps = -heap.back().first;
+    int agent = heap.back().second;
+    heap.pop_back();
+
+    // skip agents that were reached by a shorter path before
+    if (distance[agent] >= 0) continue;
+    distance[agent] = steps;
+    sum += steps;
+
+    for (int p=first[agent]; p<first[agent+1]; p++)
+    {
+      // links without weight can't be travelled
+      if (weights[p] == 0 || distance[peers[p]] >= 0) continue;
+      heap.push_back(make_pair(-(steps + 1 / weights[p]), peers[p]));
+      push_heap(heap.begin(), heap.end());
+    }
+  }
+  return sum;
+}
+
+
+
+void* WeightedGraph::pathlengthWorker(void* arg)
+// keeps taking the next source agent until all agents are done
+{
+  PathlengthJob* job = static_cast<PathlengthJob*>(arg);
+  WeightedGraph* graph = job->graph;
+  Memory::Scope scope(MEMORY_SCRATCH);
+
+  // every thread reuses its own arrays for all of its sources
+  vector<double> distance(graph->nr_of_agents);
+  vector< pair<double,int> > heap;
+  heap.reserve(graph->peers.size() + 1);
+
+  int source;
+  while ( (source = __sync_fetch_and_add(job->next_source, 1)) < graph->nr_of_agents )
+  {
+    job->sum += graph->pathlengths(source, distance, heap);
+  }
+  return NULL;
+}
+
+
+
+double WeightedGraph::avgpath()
+// returns the average weighted path length; like the unweighted avgpath(),
+// this divides the sum of the path lengths between all connected agents by n(n-1)
+{
+  if (nr_of_agents < 2) return 0;
+
+  // use one thread per processor
+  int nr_of_threads = sysconf(_SC_NPROCESSORS_ONLN);
+  if (nr_of_threads < 1) nr_of_threads = 1;
+  if (nr_of_threads > nr_of_agents) nr_of_threads = nr_of_agents;
+
+  int next_source = 0;
+  vector<PathlengthJob> jobs(nr_of_threads);
+  vector<pthread_t> threads(nr_of_threads);
+  vector<bool> started(nr_of_threads, false);
+
+  for (int t=0; t<nr_of_threads; t++)
+  {
+    jobs[t].graph = this;
+    jobs[t].next_source = &next_source;
+    jobs[t].sum = 0;
+    started[t] = (pthread_create(&threads[t], NULL, pathlengthWorker, &jobs[t]) == 0);
+  }
+
+  // if no thread could be started, do the work in this one
+  if (!started[0]) pathlengthWorker(&jobs[0]);
+
+  double sum = 0;
+  for (int t=0; t<nr_of_threads; t++)
+  {
+    if (started[t]) pthread_join(threads[t], NULL);
+    sum += jobs[t].sum;
+  }
+
+  return sum / (static_cast<double>(nr_of_agents) * (nr_of_agents - 1));
+}
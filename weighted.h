@@ -0,0 +1,43 @@
+/*
+weighted.h: statistics of the network that take the link weights into account
+*/
+
+#ifndef WEIGHTED_H
+#define WEIGHTED_H
+
+#include "main.h"
+
+class WeightedGraph
+{
+public:
+
+  // constructor; takes a compact snapshot of all agents' links and weights
+  WeightedGraph(int nr_of_agents, Agent population[]);
+
+  double clusteringBarrat();
+  // returns the weighted clustering coefficient of Barrat et al. (2004)
+
+  double clusteringOnnela();
+  // returns the weighted clustering coefficient of Onnela et al. (2005)
+
+  double assortativity();
+  // returns the strength assortativity coefficient of the network
+
+  double avgpath();
+  // returns the average weighted path length, where the length of
+  // a link is the inverse of its weight (Opsahl et al., 2010)
+
+private:
+  double pathlengths(int source, vector<double> &distance, vector< pair<double,int> > &heap);
+  static void* pathlengthWorker(void* job);
+
+  int nr_of_agents;
+  double max_weight;
+  vector<int> first; // position of each agent's first peer in the arrays below
+  vector<int> peers; // the peers of all agents, grouped by agent
+  vector<double> weights; // the weight of the link to each peer
+  vector<double> strength; // sum of the weights of each agent's links
+};
+
+#endif
+// WEIGHTED_H